@@ -0,0 +1,318 @@
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include <vector>
+
+#include "fourier_transform/Convolution.h"
+#include "fourier_transform/Fft2d.h"
+#include "fourier_transform/FftPlan.h"
+#include "fourier_transform/SlidingDft.h"
+#include "fourier_transform/Fourier.h"
+#include "fourier_transform/Spectrogram.h"
+
+std::vector<float> createSamples(const unsigned int size) {
+    std::vector<float> samples = {};
+    for (unsigned int i = 0; i < size; i++) {
+        const auto t = static_cast<float>(i);
+        samples.push_back(std::sin(0.01F * t) + 0.5F * std::sin(0.37F * t));
+    }
+    return samples;
+}
+
+static void Fft(benchmark::State &state) {
+    const auto samples = createSamples(state.range(0));
+    for (auto _ : state) {
+        auto result = fourier::fft(samples, 44100);
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(Fft)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Unit(benchmark::kMicrosecond);
+
+// the same transform as Fft, without the DataPoints
+static void FftRaw(benchmark::State &state) {
+    const auto samples = createSamples(state.range(0));
+    auto bins = std::vector<std::complex<float>>(samples.size() / 2 + 1);
+    for (auto _ : state) {
+        fourier::fft<float>(samples, bins);
+        benchmark::DoNotOptimize(bins.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(FftRaw)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Unit(benchmark::kMicrosecond);
+
+static void FftMagnitudes(benchmark::State &state) {
+    const auto samples = createSamples(state.range(0));
+    auto magnitudes = std::vector<float>(samples.size() / 2 + 1);
+    for (auto _ : state) {
+        fourier::fftMagnitudes<float>(samples, magnitudes);
+        benchmark::DoNotOptimize(magnitudes.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(FftMagnitudes)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Unit(benchmark::kMicrosecond);
+
+static void FftRawDouble(benchmark::State &state) {
+    const auto floatSamples = createSamples(state.range(0));
+    const auto samples = std::vector<double>(floatSamples.begin(), floatSamples.end());
+    auto bins = std::vector<std::complex<double>>(samples.size() / 2 + 1);
+    for (auto _ : state) {
+        fourier::fft<double>(samples, bins);
+        benchmark::DoNotOptimize(bins.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(FftRawDouble)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Unit(benchmark::kMicrosecond);
+
+static void FftPlanForward(benchmark::State &state) {
+    const auto samples = createSamples(state.range(0));
+    const auto plan = fourier::FftPlan(state.range(0));
+    auto buffer = std::vector<std::complex<float>>(samples.begin(), samples.end());
+    for (auto _ : state) {
+        plan.forward(buffer);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(FftPlanForward)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Unit(benchmark::kMicrosecond);
+
+// 2^16, 2^3 3^2 5^3 7^2 (mixed radix) and the primes around them (Bluestein)
+static void FftPlanForwardAnySize(benchmark::State &state) {
+    const auto samples = createSamples(state.range(0));
+    const auto plan = fourier::FftPlan(state.range(0));
+    auto buffer = std::vector<std::complex<float>>(samples.begin(), samples.end());
+    for (auto _ : state) {
+        plan.forward(buffer);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(FftPlanForwardAnySize)
+      ->Arg(65536)
+      ->Arg(65537)
+      ->Arg(441000)
+      ->Arg(441011)
+      ->Unit(benchmark::kMicrosecond);
+
+// the second argument selects the kernel: 0 = scalar, 1 = SSE3, 2 = AVX2
+static void FftKernelForward(benchmark::State &state) {
+    const std::array<const fourier::FftKernel *, 3> kernels = {
+          &fourier::scalarFftKernel(), //
+          fourier::sse3FftKernel(),    //
+          fourier::avx2FftKernel()     //
+    };
+    const auto *kernel = kernels[state.range(1)];
+    if (kernel == nullptr) {
+        state.SkipWithError("Kernel is not supported by this build");
+        return;
+    }
+    state.SetLabel(kernel->name);
+
+    const auto samples = createSamples(state.range(0));
+    const auto plan = fourier::FftPlan(state.range(0), *kernel);
+    auto buffer = std::vector<std::complex<float>>(samples.begin(), samples.end());
+    for (auto _ : state) {
+        plan.forward(buffer);
+        benchmark::DoNotOptimize(buffer.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(FftKernelForward)
+      ->ArgsProduct({{1 << 10, 1 << 16, 1 << 20, 1 << 24}, {0, 1, 2}})
+      ->Unit(benchmark::kMillisecond);
+
+static void RealFftPlanForward(benchmark::State &state) {
+    const auto samples = createSamples(state.range(0));
+    const auto plan = fourier::RealFftPlan(state.range(0));
+    auto bins = std::vector<std::complex<float>>(plan.binCount());
+    for (auto _ : state) {
+        plan.forward(samples, bins);
+        benchmark::DoNotOptimize(bins.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(RealFftPlanForward)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Unit(benchmark::kMicrosecond);
+
+static void FftPlanCreation(benchmark::State &state) {
+    for (auto _ : state) {
+        auto plan = fourier::FftPlan(state.range(0));
+        benchmark::DoNotOptimize(plan);
+    }
+}
+BENCHMARK(FftPlanCreation)->RangeMultiplier(8)->Range(1 << 10, 1 << 22)->Unit(benchmark::kMicrosecond);
+
+// a stroke of a few thousand points, with the highest resolution the FourierTransform scene uses
+static void Dft2(benchmark::State &state) {
+    std::vector<glm::vec2> points = {};
+    for (int i = 0; i < state.range(0); i++) {
+        const auto t = static_cast<float>(i) * 0.01F;
+        points.emplace_back(std::cos(t) + 0.3F * std::cos(7.0F * t), std::sin(t));
+    }
+    for (auto _ : state) {
+        auto result = fourier::dft2(points, 500);
+        benchmark::DoNotOptimize(result.data());
+    }
+}
+BENCHMARK(Dft2)->Arg(1000)->Arg(4000)->Arg(4001)->Unit(benchmark::kMicrosecond);
+
+// the number of tracked bins of a window of 1024 samples, every sample updates all of them
+static void SlidingDftPush(benchmark::State &state) {
+    const auto samples = createSamples(44100);
+    auto bins = std::vector<unsigned int>();
+    for (unsigned int i = 0; i < state.range(0); i++) {
+        bins.push_back(1 + i * 7);
+    }
+    auto slidingDft = fourier::SlidingDft(1024, bins);
+    for (auto _ : state) {
+        slidingDft.push(samples);
+        benchmark::DoNotOptimize(slidingDft.value(0));
+    }
+    state.SetItemsProcessed(state.iterations() * samples.size());
+}
+BENCHMARK(SlidingDftPush)->Arg(1)->Arg(8)->Arg(50)->Unit(benchmark::kMicrosecond);
+
+static void Goertzel(benchmark::State &state) {
+    const auto samples = createSamples(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(fourier::goertzel(samples, 17.0));
+    }
+    state.SetItemsProcessed(state.iterations() * samples.size());
+}
+BENCHMARK(Goertzel)->Arg(1024)->Unit(benchmark::kMicrosecond);
+
+// a spectrogram of one minute of 44.1 kHz audio with 75 % overlap, by calling fft for every frame
+static void SpectrogramWithFft(benchmark::State &state) {
+    const auto samples = createSamples(44100 * 60);
+    const auto frameSize = state.range(0);
+    const auto hop = frameSize / 4;
+    for (auto _ : state) {
+        auto frames = std::vector<std::vector<fourier::DataPoint>>();
+        for (size_t start = 0; start + frameSize <= samples.size(); start += hop) {
+            const auto frame = std::vector<float>(samples.begin() + start, samples.begin() + start + frameSize);
+            frames.push_back(fourier::fft(frame, 44100));
+        }
+        benchmark::DoNotOptimize(frames.data());
+    }
+}
+BENCHMARK(SpectrogramWithFft)->RangeMultiplier(4)->Range(256, 4096)->Unit(benchmark::kMillisecond);
+
+static void SpectrogramWithStft(benchmark::State &state) {
+    const auto samples = createSamples(44100 * 60);
+    const auto frameSize = state.range(0);
+    for (auto _ : state) {
+        auto spectrogram = fourier::stft(samples, frameSize, frameSize / 4);
+        benchmark::DoNotOptimize(spectrogram.magnitudes.data());
+    }
+}
+BENCHMARK(SpectrogramWithStft)->RangeMultiplier(4)->Range(256, 4096)->Unit(benchmark::kMillisecond);
+
+// one second of 44.1 kHz audio, with kernels around the size up to which convolve applies them directly
+static void Convolve(benchmark::State &state) {
+    const auto signal = createSamples(44100);
+    const auto kernel = createSamples(state.range(0));
+    for (auto _ : state) {
+        auto result = fourier::convolve(signal, kernel);
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetItemsProcessed(state.iterations() * signal.size());
+}
+BENCHMARK(Convolve)->Arg(16)->Arg(48)->Arg(49)->Arg(256)->Arg(4096)->Unit(benchmark::kMicrosecond);
+
+// the direct convolution convolve uses for small kernels, for every kernel size
+static void ConvolveDirect(benchmark::State &state) {
+    const auto signal = createSamples(44100);
+    const auto kernel = createSamples(state.range(0));
+    for (auto _ : state) {
+        auto result = std::vector<float>(signal.size() + kernel.size() - 1, 0.0F);
+        for (size_t j = 0; j < kernel.size(); j++) {
+            for (size_t i = 0; i < signal.size(); i++) {
+                result[i + j] += kernel[j] * signal[i];
+            }
+        }
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetItemsProcessed(state.iterations() * signal.size());
+}
+BENCHMARK(ConvolveDirect)->Arg(16)->Arg(48)->Arg(49)->Arg(256)->Arg(4096)->Unit(benchmark::kMicrosecond);
+
+// a 512 x 512 height map with square kernels, the ones up to 33 x 33 are applied directly
+static void Convolve2d(benchmark::State &state) {
+    const size_t size = 512;
+    const auto values = createSamples(size * size);
+    const auto kernelSize = state.range(0);
+    const auto kernel = createSamples(kernelSize * kernelSize);
+    for (auto _ : state) {
+        auto result =
+              fourier::convolve2d(values, size, size, kernel, kernelSize, kernelSize, fourier::ConvolutionMode::Same);
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(Convolve2d)->Arg(5)->Arg(15)->Arg(33)->Arg(35)->Arg(65)->Unit(benchmark::kMillisecond);
+
+// square height maps from 1k x 1k to 8k x 8k
+static void RealFft2dForward(benchmark::State &state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    const auto values = createSamples(size * size);
+    const auto plan = fourier::RealFft2dPlan(size, size);
+    auto bins = std::vector<std::complex<float>>(plan.binCount());
+    for (auto _ : state) {
+        plan.forward(values, bins);
+        benchmark::DoNotOptimize(bins.data());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(RealFft2dForward)->RangeMultiplier(2)->Range(1 << 10, 1 << 13)->Unit(benchmark::kMillisecond);
+
+constexpr float BLUR_SIGMA = 4.0F;
+
+static void GaussianBlurFft(benchmark::State &state) {
+    const auto size = static_cast<size_t>(state.range(0));
+    auto values = createSamples(size * size);
+    for (auto _ : state) {
+        fourier::gaussianBlur(values, size, size, BLUR_SIGMA);
+        benchmark::DoNotOptimize(values.data());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(GaussianBlurFft)->RangeMultiplier(2)->Range(1 << 10, 1 << 13)->Unit(benchmark::kMillisecond);
+
+// the same blur as a naive 2D convolution with a kernel that covers 3 sigma in every direction
+static void GaussianBlurNaive(benchmark::State &state) {
+    const auto size = static_cast<int>(state.range(0));
+    const auto values = createSamples(size * size);
+    const auto radius = static_cast<int>(std::ceil(3.0F * BLUR_SIGMA));
+    const auto kernelSize = 2 * radius + 1;
+    auto kernel = std::vector<float>(kernelSize * kernelSize);
+    for (int y = -radius; y <= radius; y++) {
+        for (int x = -radius; x <= radius; x++) {
+            const auto distance = static_cast<float>(x * x + y * y);
+            kernel[(y + radius) * kernelSize + x + radius] = std::exp(-distance / (2.0F * BLUR_SIGMA * BLUR_SIGMA));
+        }
+    }
+
+    auto result = std::vector<float>(values.size());
+    for (auto _ : state) {
+#pragma omp parallel for
+        for (int y = 0; y < size; y++) {
+            for (int x = 0; x < size; x++) {
+                auto sum = 0.0F;
+                for (int ky = -radius; ky <= radius; ky++) {
+                    const auto row = (y + ky + size) % size;
+                    for (int kx = -radius; kx <= radius; kx++) {
+                        const auto column = (x + kx + size) % size;
+                        sum += values[row * size + column] * kernel[(ky + radius) * kernelSize + kx + radius];
+                    }
+                }
+                result[y * size + x] = sum;
+            }
+        }
+        benchmark::DoNotOptimize(result.data());
+    }
+    state.SetItemsProcessed(state.iterations() * values.size());
+}
+BENCHMARK(GaussianBlurNaive)->RangeMultiplier(2)->Range(1 << 10, 1 << 13)->Iterations(1)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -1,12 +1,12 @@
 #include <benchmark/benchmark.h>
+#include <filesystem>
 
 #include "quad_tree/QuadTree.h"
 
 constexpr unsigned int start = 16;
 constexpr unsigned int end = 65536 * 8;
 
-QuadTree<unsigned int> createTree(const unsigned int size, const unsigned int k) {
-    QuadTree<unsigned int> tree = QuadTree<unsigned int>(k);
+std::vector<std::pair<glm::vec3, unsigned int>> createElements(const unsigned int size) {
     std::vector<std::pair<glm::vec3, unsigned int>> elements = {};
     const unsigned int dimension = std::sqrt(size);
     for (unsigned int i = 0; i < size; i++) {
@@ -14,7 +14,12 @@ QuadTree<unsigned int> createTree(const unsigned int size, const unsigned int k)
         unsigned int z = i / dimension;
         elements.push_back(std::make_pair(glm::vec3(x, 0, z), x * dimension + z));
     }
-    tree.insert(elements);
+    return elements;
+}
+
+QuadTree<unsigned int> createTree(const unsigned int size, const unsigned int k) {
+    QuadTree<unsigned int> tree = QuadTree<unsigned int>(k);
+    tree.insert(createElements(size));
     return tree;
 }
 
@@ -42,4 +47,366 @@ K(128)
 K(256)
 K(512)
 
+static void KnnQuery(benchmark::State &state) {
+    const unsigned int size = end;
+    const unsigned int k = state.range(0);
+    auto tree = createTree(size, DEFAULT_MAX_ELEMENTS_PER_NODE);
+
+    const float center = std::sqrt(size) / 2.0F;
+    std::vector<unsigned int> result = {};
+    result.reserve(k);
+    for (auto _ : state) {
+        result.clear();
+        tree.get(glm::vec3(center, 0, center), k, result);
+        benchmark::DoNotOptimize(result.data());
+    }
+}
+BENCHMARK(KnnQuery)->RangeMultiplier(2)->Range(1, 1024);
+
+// the same grid as createElements, but stored in a tree of the given dimension and metric
+template <typename TreeType> static void KnnQueryWith(benchmark::State &state) {
+    const unsigned int size = end;
+    const unsigned int k = state.range(0);
+    std::vector<typename TreeType::Element> elements = {};
+    for (const auto &element : createElements(size)) {
+        typename TreeType::Vec point = {};
+        point[0] = element.first.x;
+        point[TreeType::DIMENSION - 1] = element.first.z;
+        elements.emplace_back(point, element.second);
+    }
+    auto tree = TreeType(DEFAULT_MAX_ELEMENTS_PER_NODE);
+    tree.insert(elements);
+
+    const auto query = typename TreeType::Vec(std::sqrt(size) / 2.0F);
+    std::vector<unsigned int> result = {};
+    result.reserve(k);
+    for (auto _ : state) {
+        result.clear();
+        tree.get(query, k, result);
+        benchmark::DoNotOptimize(result.data());
+    }
+}
+using Euclidean3D = QuadTree<unsigned int>;
+using Euclidean2D = QuadTree<unsigned int, 2>;
+using Manhattan3D = QuadTree<unsigned int, 3, ManhattanMetric>;
+using Chebyshev3D = QuadTree<unsigned int, 3, ChebyshevMetric>;
+BENCHMARK_TEMPLATE(KnnQueryWith, Euclidean3D)->RangeMultiplier(8)->Range(1, 512);
+BENCHMARK_TEMPLATE(KnnQueryWith, Euclidean2D)->RangeMultiplier(8)->Range(1, 512);
+BENCHMARK_TEMPLATE(KnnQueryWith, Manhattan3D)->RangeMultiplier(8)->Range(1, 512);
+BENCHMARK_TEMPLATE(KnnQueryWith, Chebyshev3D)->RangeMultiplier(8)->Range(1, 512);
+
+std::vector<glm::vec3> createQueries(const unsigned int size, const unsigned int count) {
+    std::vector<glm::vec3> queries = {};
+    const float dimension = std::sqrt(size);
+    for (unsigned int i = 0; i < count; i++) {
+        const auto x = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
+        const auto z = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
+        queries.emplace_back(x * dimension, 0, z * dimension);
+    }
+    return queries;
+}
+
+static void KnnQueryLoop(benchmark::State &state) {
+    const unsigned int k = state.range(0);
+    auto tree = createTree(end, DEFAULT_MAX_ELEMENTS_PER_NODE);
+    const auto queries = createQueries(end, 100000);
+
+    for (auto _ : state) {
+        for (const auto &query : queries) {
+            std::vector<unsigned int> result = {};
+            tree.get(query, k, result);
+            benchmark::DoNotOptimize(result.data());
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+BENCHMARK(KnnQueryLoop)->Arg(1)->Arg(8)->Arg(64)->Unit(benchmark::kMillisecond);
+
+// points spread uniformly over the same square as the grid of createElements, without any ties
+std::vector<std::pair<glm::vec3, unsigned int>> createRandomElements(const unsigned int size) {
+    std::vector<std::pair<glm::vec3, unsigned int>> elements = {};
+    const float dimension = std::sqrt(size);
+    for (unsigned int i = 0; i < size; i++) {
+        const auto x = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
+        const auto z = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
+        elements.push_back(std::make_pair(glm::vec3(x * dimension, 0, z * dimension), i));
+    }
+    return elements;
+}
+
+/*
+ * Runs approximate kNN queries on ~1M points and reports the recall next to the timing.
+ * The arguments are epsilon in percent, the maximum number of elements per leaf and whether the points are random
+ * instead of a grid.
+ * Because the grid has many ties, a result counts as correct if it is not further away than the exact k-th neighbour.
+ */
+void runApproximateKnnBenchmark(benchmark::State &state, const QuadTreeSearchParams &params) {
+    const unsigned int size = 1 << 20;
+    const unsigned int k = 16;
+    const auto elements = state.range(2) != 0 ? createRandomElements(size) : createElements(size);
+    auto tree = QuadTree<unsigned int>(state.range(1));
+    tree.insert(elements);
+    const auto queries = createQueries(size, 10000);
+
+    // the values of both point sets are a permutation of [0, size)
+    std::vector<glm::vec3> points = std::vector<glm::vec3>(size);
+    for (const auto &element : elements) {
+        points[element.second] = element.first;
+    }
+
+    std::vector<float> exactKthDistances = {};
+    for (const auto &query : queries) {
+        std::vector<unsigned int> result = {};
+        tree.get(query, k, result);
+        exactKthDistances.push_back(distanceSq(points[result.back()], query));
+    }
+
+    size_t correct = 0;
+    size_t total = 0;
+    std::vector<unsigned int> result = {};
+    for (auto _ : state) {
+        for (unsigned int i = 0; i < queries.size(); i++) {
+            result.clear();
+            tree.get(queries[i], k, result, params);
+            for (const auto value : result) {
+                correct += distanceSq(points[value], queries[i]) <= exactKthDistances[i] ? 1 : 0;
+            }
+            total += k;
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * queries.size());
+    state.counters["recall"] = static_cast<double>(correct) / static_cast<double>(total);
+}
+
+static void ApproximateKnn(benchmark::State &state) {
+    runApproximateKnnBenchmark(state, {.epsilon = static_cast<float>(state.range(0)) / 100.0F});
+}
+BENCHMARK(ApproximateKnn)
+      ->ArgsProduct({{0, 10, 25, 50, 100, 200}, {16, 32, DEFAULT_MAX_ELEMENTS_PER_NODE}, {0, 1}})
+      ->ArgNames({"epsilonPercent", "leafSize", "random"})
+      ->Unit(benchmark::kMillisecond);
+
+static void ApproximateKnnMaxLeaves(benchmark::State &state) {
+    runApproximateKnnBenchmark(state, {.maxLeaves = static_cast<unsigned int>(state.range(0))});
+}
+BENCHMARK(ApproximateKnnMaxLeaves)
+      ->ArgsProduct({{1, 2, 4, 8}, {16, 32, DEFAULT_MAX_ELEMENTS_PER_NODE}, {0, 1}})
+      ->ArgNames({"maxLeaves", "leafSize", "random"})
+      ->Unit(benchmark::kMillisecond);
+
+static void KnnQueryBatch(benchmark::State &state) {
+    const unsigned int k = state.range(0);
+    auto tree = createTree(end, DEFAULT_MAX_ELEMENTS_PER_NODE);
+    const auto queries = createQueries(end, 100000);
+
+    QuadTree<unsigned int>::BatchResult result = {};
+    for (auto _ : state) {
+        tree.getBatch(queries, k, result);
+        benchmark::DoNotOptimize(result.values.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * queries.size());
+}
+BENCHMARK(KnnQueryBatch)->Arg(1)->Arg(8)->Arg(64)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/*
+ * Range queries compared to the previous workaround: a kNN query with a large enough k that is filtered afterwards.
+ */
+static void RadiusQuery(benchmark::State &state) {
+    const float radius = state.range(0);
+    auto tree = createTree(end, DEFAULT_MAX_ELEMENTS_PER_NODE);
+    const float center = std::sqrt(end) / 2.0F;
+    const auto query = glm::vec3(center, 0, center);
+
+    for (auto _ : state) {
+        unsigned int count = 0;
+        tree.getInRadius(query, radius, [&count](const glm::vec3 &, const unsigned int &) { count++; });
+        benchmark::DoNotOptimize(count);
+    }
+}
+BENCHMARK(RadiusQuery)->RangeMultiplier(4)->Range(8, 128);
+
+static void RadiusQueryWithKnn(benchmark::State &state) {
+    const float radius = state.range(0);
+    auto tree = createTree(end, DEFAULT_MAX_ELEMENTS_PER_NODE);
+    const float center = std::sqrt(end) / 2.0F;
+    const auto query = glm::vec3(center, 0, center);
+    const auto k = static_cast<unsigned int>(4.0F * (radius + 1.0F) * (radius + 1.0F));
+
+    for (auto _ : state) {
+        std::vector<unsigned int> result = {};
+        tree.get(query, k, result);
+        unsigned int count = 0;
+        for (const auto value : result) {
+            const auto x = value / static_cast<unsigned int>(std::sqrt(end));
+            const auto z = value % static_cast<unsigned int>(std::sqrt(end));
+            if (distanceSq(glm::vec3(x, 0, z), query) <= radius * radius) {
+                count++;
+            }
+        }
+        benchmark::DoNotOptimize(count);
+    }
+}
+BENCHMARK(RadiusQueryWithKnn)->RangeMultiplier(4)->Range(8, 128);
+
+static void BoxQuery(benchmark::State &state) {
+    const float halfSize = state.range(0);
+    auto tree = createTree(end, DEFAULT_MAX_ELEMENTS_PER_NODE);
+    const float center = std::sqrt(end) / 2.0F;
+    BoundingBox3 box = {};
+    box.update(glm::vec3(center - halfSize, -1.0F, center - halfSize));
+    box.update(glm::vec3(center + halfSize, 1.0F, center + halfSize));
+
+    for (auto _ : state) {
+        unsigned int count = 0;
+        tree.getInBox(box, [&count](const glm::vec3 &, const unsigned int &) { count++; });
+        benchmark::DoNotOptimize(count);
+    }
+}
+BENCHMARK(BoxQuery)->RangeMultiplier(4)->Range(8, 128);
+
+static void BoxQueryWithKnn(benchmark::State &state) {
+    const float halfSize = state.range(0);
+    auto tree = createTree(end, DEFAULT_MAX_ELEMENTS_PER_NODE);
+    const float center = std::sqrt(end) / 2.0F;
+    BoundingBox3 box = {};
+    box.update(glm::vec3(center - halfSize, -1.0F, center - halfSize));
+    box.update(glm::vec3(center + halfSize, 1.0F, center + halfSize));
+    // the box is covered by the circle around its corners
+    const auto k = static_cast<unsigned int>(8.0F * (halfSize + 1.0F) * (halfSize + 1.0F));
+
+    for (auto _ : state) {
+        std::vector<unsigned int> result = {};
+        tree.get(box.center(), k, result);
+        unsigned int count = 0;
+        for (const auto value : result) {
+            const auto x = value / static_cast<unsigned int>(std::sqrt(end));
+            const auto z = value % static_cast<unsigned int>(std::sqrt(end));
+            if (box.contains(glm::vec3(x, 0, z))) {
+                count++;
+            }
+        }
+        benchmark::DoNotOptimize(count);
+    }
+}
+BENCHMARK(BoxQueryWithKnn)->RangeMultiplier(4)->Range(8, 128);
+
+Frustum createFrustum(const glm::vec3 &eye, const float depth) {
+    // looking down the x axis with a 90 degree field of view
+    Frustum frustum = {};
+    frustum.planes = {
+          glm::vec4(1.0F, 0.0F, 1.0F, -eye.x - eye.z),  //
+          glm::vec4(1.0F, 0.0F, -1.0F, -eye.x + eye.z), //
+          glm::vec4(1.0F, 1.0F, 0.0F, -eye.x - eye.y),  //
+          glm::vec4(1.0F, -1.0F, 0.0F, -eye.x + eye.y), //
+          glm::vec4(1.0F, 0.0F, 0.0F, -eye.x - 0.1F),   //
+          glm::vec4(-1.0F, 0.0F, 0.0F, eye.x + depth),  //
+    };
+    return frustum;
+}
+
+static void FrustumQuery(benchmark::State &state) {
+    const float depth = state.range(0);
+    auto tree = createTree(end, DEFAULT_MAX_ELEMENTS_PER_NODE);
+    const float center = std::sqrt(end) / 2.0F;
+    const auto frustum = createFrustum(glm::vec3(center, 0, center), depth);
+
+    for (auto _ : state) {
+        unsigned int count = 0;
+        tree.getInFrustum(frustum, [&count](const glm::vec3 &, const unsigned int &) { count++; });
+        benchmark::DoNotOptimize(count);
+    }
+}
+BENCHMARK(FrustumQuery)->RangeMultiplier(4)->Range(8, 128);
+
+static void FrustumQueryWithKnn(benchmark::State &state) {
+    const float depth = state.range(0);
+    auto tree = createTree(end, DEFAULT_MAX_ELEMENTS_PER_NODE);
+    const float center = std::sqrt(end) / 2.0F;
+    const auto frustum = createFrustum(glm::vec3(center, 0, center), depth);
+    // the frustum is covered by the circle around the camera that reaches its far corners
+    const auto k = static_cast<unsigned int>(3.15F * 2.0F * (depth + 1.0F) * (depth + 1.0F));
+
+    for (auto _ : state) {
+        std::vector<unsigned int> result = {};
+        tree.get(glm::vec3(center, 0, center), k, result);
+        unsigned int count = 0;
+        for (const auto value : result) {
+            const auto x = value / static_cast<unsigned int>(std::sqrt(end));
+            const auto z = value % static_cast<unsigned int>(std::sqrt(end));
+            if (frustum.contains(glm::vec3(x, 0, z))) {
+                count++;
+            }
+        }
+        benchmark::DoNotOptimize(count);
+    }
+}
+BENCHMARK(FrustumQueryWithKnn)->RangeMultiplier(4)->Range(8, 128);
+
+static void Build(benchmark::State &state) {
+    const unsigned int size = state.range(0);
+    const auto elements = createElements(size);
+
+    for (auto _ : state) {
+        auto tree = QuadTree<unsigned int>();
+        tree.insert(elements);
+        benchmark::DoNotOptimize(tree);
+    }
+
+    state.SetItemsProcessed(state.iterations() * size);
+}
+BENCHMARK(Build)->RangeMultiplier(8)->Range(start, end * 2)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+void runStreamingInsertBenchmark(benchmark::State &state, const unsigned int batchSize) {
+    const unsigned int size = state.range(0);
+    const auto elements = createElements(size);
+
+    for (auto _ : state) {
+        auto tree = QuadTree<unsigned int>();
+        for (unsigned int i = 0; i < size; i += batchSize) {
+            tree.insert(elements.begin() + i, elements.begin() + std::min(i + batchSize, size));
+        }
+        benchmark::DoNotOptimize(tree);
+    }
+
+    state.SetItemsProcessed(state.iterations() * size);
+}
+
+static void StreamingInsert(benchmark::State &state) { runStreamingInsertBenchmark(state, 1); }
+BENCHMARK(StreamingInsert)->RangeMultiplier(10)->Range(10000, 1000000)->Unit(benchmark::kMillisecond);
+
+static void StreamingBatchInsert(benchmark::State &state) { runStreamingInsertBenchmark(state, 1000); }
+BENCHMARK(StreamingBatchInsert)->RangeMultiplier(10)->Range(10000, 1000000)->Unit(benchmark::kMillisecond);
+
+// time from nothing to the first query result, either by building the tree or by mapping a saved one
+static void ColdStartBuild(benchmark::State &state) {
+    const unsigned int size = state.range(0);
+    const auto elements = createElements(size);
+
+    for (auto _ : state) {
+        auto tree = QuadTree<unsigned int>();
+        tree.insert(elements);
+        unsigned int result = 0;
+        benchmark::DoNotOptimize(tree.get(glm::vec3(0.0F), result));
+    }
+}
+BENCHMARK(ColdStartBuild)->RangeMultiplier(10)->Range(10000, 1000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void ColdStartMapped(benchmark::State &state) {
+    const unsigned int size = state.range(0);
+    const auto filePath = (std::filesystem::temp_directory_path() / "quad_tree_bench.bin").string();
+    createTree(size, DEFAULT_MAX_ELEMENTS_PER_NODE).save(filePath);
+
+    for (auto _ : state) {
+        auto tree = QuadTree<unsigned int>::openMapped(filePath);
+        unsigned int result = 0;
+        benchmark::DoNotOptimize(tree->get(glm::vec3(0.0F), result));
+    }
+
+    std::filesystem::remove(filePath);
+}
+BENCHMARK(ColdStartMapped)->RangeMultiplier(10)->Range(10000, 1000000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
 BENCHMARK_MAIN();
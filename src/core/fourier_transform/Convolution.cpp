@@ -0,0 +1,259 @@
+#include "Convolution.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <complex>
+#include <iostream>
+
+#include "Fft2d.h"
+#include "FftPlan.h"
+
+namespace fourier {
+
+/*
+ * Kernels with at most this many values are applied directly, that is faster than two transforms per block
+ * (measured with the convolution benchmarks in FourierBench).
+ */
+constexpr size_t DIRECT_CONVOLUTION_MAX_KERNEL_SIZE = 48;
+
+/*
+ * In 2D the transforms have to cover the whole padded grid, so the crossover depends on the size of the grid:
+ * applying one kernel value to one output costs about 1 / FFT_2D_COST of what a 2D FFT costs per value and stage.
+ */
+constexpr double FFT_2D_COST = 15.0;
+
+namespace {
+
+// written out, because std::complex has to handle inf and nan in multiplications and is much slower
+std::complex<float> multiply(const std::complex<float> &a, const std::complex<float> &b) {
+    return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+}
+
+// the index of the first returned value in the full convolution
+size_t convolutionBegin(size_t kernelSize, ConvolutionMode mode) {
+    switch (mode) {
+    case ConvolutionMode::Full:
+        return 0;
+    case ConvolutionMode::Same:
+        return (kernelSize - 1) / 2;
+    case ConvolutionMode::Valid:
+        return kernelSize - 1;
+    }
+    return 0;
+}
+
+std::vector<float> reversed(std::span<const float> values) { return {values.rbegin(), values.rend()}; }
+
+/*
+ * Adds up the signal scaled by one kernel value after the other,
+ * so that the inner loop runs over consecutive values of the signal and the output.
+ */
+void convolveDirect(std::span<const float> signal, std::span<const float> kernel, size_t begin,
+                    std::span<float> output) {
+    const size_t end = begin + output.size();
+    for (size_t j = 0; j < kernel.size(); j++) {
+        // the outputs n in [j, j + signal.size()) use kernel[j]
+        const auto first = std::max(begin, j);
+        const auto last = std::min(end, j + signal.size());
+        const auto weight = kernel[j];
+        for (size_t n = first; n < last; n++) {
+            output[n - begin] += weight * signal[n - j];
+        }
+    }
+}
+
+/*
+ * Overlap-save: every block transforms fftSize signal values and keeps the fftSize - kernel.size() + 1 outputs,
+ * that did not wrap around. Blocks do not share any outputs, so they can be computed in parallel.
+ */
+void convolveFft(std::span<const float> signal, std::span<const float> kernel, size_t begin,
+                 std::span<float> output) {
+    const auto kernelSize = kernel.size();
+    // big blocks waste less of every transform on the overlap,
+    // but there is no need for them to be bigger than the output
+    const auto fftSize = std::min(std::bit_ceil(4 * kernelSize), std::bit_ceil(output.size() + kernelSize - 1));
+    const auto step = fftSize - kernelSize + 1;
+    const auto &plan = cachedRealPlan(fftSize);
+
+    // divided by fftSize, because the inverse transform is not
+    auto kernelBins = std::vector<std::complex<float>>(plan.binCount());
+    {
+        auto padded = std::vector<float>(fftSize, 0.0F);
+        std::copy(kernel.begin(), kernel.end(), padded.begin());
+        plan.forward(padded, kernelBins);
+        for (auto &bin : kernelBins) {
+            bin /= static_cast<float>(fftSize);
+        }
+    }
+
+    const auto blockCount = static_cast<int>((output.size() + step - 1) / step);
+#pragma omp parallel
+    {
+        auto block = std::vector<float>(fftSize);
+        auto bins = std::vector<std::complex<float>>(plan.binCount());
+
+#pragma omp for
+        for (int b = 0; b < blockCount; b++) {
+            const auto first = static_cast<size_t>(b) * step;
+            const auto count = std::min(step, output.size() - first);
+            // the kernelSize - 1 signal values before the first output of the block are needed as well
+            const auto start = static_cast<ptrdiff_t>(begin + first) - static_cast<ptrdiff_t>(kernelSize - 1);
+            for (size_t i = 0; i < fftSize; i++) {
+                const auto index = start + static_cast<ptrdiff_t>(i);
+                const bool inside = index >= 0 && index < static_cast<ptrdiff_t>(signal.size());
+                block[i] = inside ? signal[index] : 0.0F;
+            }
+
+            plan.forward(block, bins);
+            for (size_t k = 0; k < bins.size(); k++) {
+                bins[k] = multiply(bins[k], kernelBins[k]);
+            }
+            plan.inverse(bins, block);
+
+            std::copy_n(block.begin() + static_cast<ptrdiff_t>(kernelSize - 1), count, output.begin() + first);
+        }
+    }
+}
+
+// row-major grid of width x height values
+struct GridView {
+    std::span<const float> values;
+    size_t width;
+    size_t height;
+};
+
+void convolve2dDirect(const GridView &grid, const GridView &kernel, size_t beginX, size_t beginY,
+                      std::span<float> output, size_t outputWidth) {
+    const auto outputHeight = static_cast<int>(output.size() / outputWidth);
+#pragma omp parallel for
+    for (int row = 0; row < outputHeight; row++) {
+        const auto y = beginY + row;
+        auto outputRow = output.subspan(row * outputWidth, outputWidth);
+        // the kernel rows that overlap the grid, every one of them is a 1D convolution of a grid row
+        const auto firstKernelRow = y >= grid.height ? y - grid.height + 1 : 0;
+        const auto lastKernelRow = std::min(kernel.height - 1, y);
+        for (size_t kernelRow = firstKernelRow; kernelRow <= lastKernelRow; kernelRow++) {
+            convolveDirect(grid.values.subspan((y - kernelRow) * grid.width, grid.width),
+                           kernel.values.subspan(kernelRow * kernel.width, kernel.width), beginX, outputRow);
+        }
+    }
+}
+
+/*
+ * Grid and kernel are padded to the size of the full convolution, so that the product of their transforms,
+ * which is a circular convolution, does not wrap around.
+ */
+void convolve2dFft(const GridView &grid, const GridView &kernel, size_t beginX, size_t beginY,
+                   std::span<float> output, size_t outputWidth) {
+    const auto fftWidth = std::bit_ceil(grid.width + kernel.width - 1);
+    const auto fftHeight = std::bit_ceil(grid.height + kernel.height - 1);
+    const auto &plan = cachedRealFft2dPlan(fftWidth, fftHeight);
+    auto padded = std::vector<float>(fftWidth * fftHeight);
+    const auto transform = [&plan, &padded, fftWidth](const GridView &view) {
+        std::fill(padded.begin(), padded.end(), 0.0F);
+        for (size_t y = 0; y < view.height; y++) {
+            const auto row = view.values.subspan(y * view.width, view.width);
+            std::copy(row.begin(), row.end(), padded.begin() + static_cast<std::ptrdiff_t>(y * fftWidth));
+        }
+        auto bins = std::vector<std::complex<float>>(plan.binCount());
+        plan.forward(padded, bins);
+        return bins;
+    };
+    auto product = transform(grid);
+    const auto kernelBins = transform(kernel);
+
+    // divided by the size, because the inverse transform is not
+    const auto scale = 1.0F / static_cast<float>(fftWidth * fftHeight);
+#pragma omp parallel for
+    for (int i = 0; i < static_cast<int>(product.size()); i++) {
+        product[i] = scale * multiply(product[i], kernelBins[i]);
+    }
+    plan.inverse(product, padded);
+
+    const auto outputHeight = output.size() / outputWidth;
+    for (size_t row = 0; row < outputHeight; row++) {
+        for (size_t column = 0; column < outputWidth; column++) {
+            output[row * outputWidth + column] = padded[(beginY + row) * fftWidth + beginX + column];
+        }
+    }
+}
+
+} // namespace
+
+size_t convolutionSize(size_t signalSize, size_t kernelSize, ConvolutionMode mode) {
+    if (signalSize == 0 || kernelSize == 0) {
+        return 0;
+    }
+    switch (mode) {
+    case ConvolutionMode::Full:
+        return signalSize + kernelSize - 1;
+    case ConvolutionMode::Same:
+        return signalSize;
+    case ConvolutionMode::Valid:
+        return signalSize >= kernelSize ? signalSize - kernelSize + 1 : 0;
+    }
+    return 0;
+}
+
+std::vector<float> convolve(std::span<const float> signal, std::span<const float> kernel, ConvolutionMode mode) {
+    auto result = std::vector<float>(convolutionSize(signal.size(), kernel.size(), mode), 0.0F);
+    if (result.empty()) {
+        return result;
+    }
+
+    // the full convolution does not change when signal and kernel are swapped, the shorter one is used as the kernel
+    const auto begin = convolutionBegin(kernel.size(), mode);
+    if (signal.size() < kernel.size()) {
+        std::swap(signal, kernel);
+    }
+    if (kernel.size() <= DIRECT_CONVOLUTION_MAX_KERNEL_SIZE) {
+        convolveDirect(signal, kernel, begin, result);
+    } else {
+        convolveFft(signal, kernel, begin, result);
+    }
+    return result;
+}
+
+std::vector<float> correlate(std::span<const float> signal, std::span<const float> kernel, ConvolutionMode mode) {
+    return convolve(signal, reversed(kernel), mode);
+}
+
+std::vector<float> convolve2d(std::span<const float> values, size_t width, size_t height, std::span<const float> kernel,
+                              size_t kernelWidth, size_t kernelHeight, ConvolutionMode mode) {
+    if (values.size() != width * height || kernel.size() != kernelWidth * kernelHeight) {
+        std::cerr << "Can not convolve " << values.size() << " values as " << width << "x" << height << " grid with "
+                  << kernel.size() << " values as " << kernelWidth << "x" << kernelHeight << " kernel" << std::endl;
+        return {};
+    }
+
+    const auto outputWidth = convolutionSize(width, kernelWidth, mode);
+    const auto outputHeight = convolutionSize(height, kernelHeight, mode);
+    auto result = std::vector<float>(outputWidth * outputHeight, 0.0F);
+    if (result.empty()) {
+        return result;
+    }
+
+    const auto grid = GridView{values, width, height};
+    const auto kernelGrid = GridView{kernel, kernelWidth, kernelHeight};
+    const auto beginX = convolutionBegin(kernelWidth, mode);
+    const auto beginY = convolutionBegin(kernelHeight, mode);
+    const auto fftSize = static_cast<double>(std::bit_ceil(width + kernelWidth - 1) *
+                                             std::bit_ceil(height + kernelHeight - 1));
+    const auto directCost = static_cast<double>(kernel.size()) * static_cast<double>(result.size());
+    if (directCost <= FFT_2D_COST * fftSize * std::log2(fftSize)) {
+        convolve2dDirect(grid, kernelGrid, beginX, beginY, result, outputWidth);
+    } else {
+        convolve2dFft(grid, kernelGrid, beginX, beginY, result, outputWidth);
+    }
+    return result;
+}
+
+std::vector<float> correlate2d(std::span<const float> values, size_t width, size_t height,
+                               std::span<const float> kernel, size_t kernelWidth, size_t kernelHeight,
+                               ConvolutionMode mode) {
+    // reversing the row-major values flips the kernel horizontally and vertically
+    return convolve2d(values, width, height, reversed(kernel), kernelWidth, kernelHeight, mode);
+}
+
+} // namespace fourier
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace fourier {
+
+/**
+ * Which part of the full convolution is returned, per axis:
+ * Full: every output the kernel overlaps the signal for, signalSize + kernelSize - 1 values
+ * Same: signalSize values, the kernel is centered on the signal value (at (kernelSize - 1) / 2)
+ * Valid: only the outputs the kernel fully overlaps the signal for, signalSize - kernelSize + 1 values
+ */
+enum class ConvolutionMode {
+    Full,
+    Same,
+    Valid,
+};
+
+size_t convolutionSize(size_t signalSize, size_t kernelSize, ConvolutionMode mode);
+
+/**
+ * y[n] = sum(signal[n - j] * kernel[j])
+ * Small kernels are applied directly. Bigger ones use overlap-save with cached real FFT plans:
+ * the signal is cut into blocks that are transformed in parallel, each one computes a separate part of the output.
+ */
+std::vector<float> convolve(std::span<const float> signal, std::span<const float> kernel,
+                            ConvolutionMode mode = ConvolutionMode::Full);
+
+/**
+ * y[n] = sum(signal[n + j - (kernelSize - 1)] * kernel[j]), the convolution with the reversed kernel.
+ */
+std::vector<float> correlate(std::span<const float> signal, std::span<const float> kernel,
+                             ConvolutionMode mode = ConvolutionMode::Full);
+
+/**
+ * The same for row-major grids of width x height values, e.g. images or height maps.
+ * The result is a row-major grid of convolutionSize(width, kernelWidth, mode) x
+ * convolutionSize(height, kernelHeight, mode) values.
+ * Big kernels use a two-dimensional FFT of the whole grid.
+ */
+std::vector<float> convolve2d(std::span<const float> values, size_t width, size_t height, std::span<const float> kernel,
+                              size_t kernelWidth, size_t kernelHeight, ConvolutionMode mode = ConvolutionMode::Full);
+std::vector<float> correlate2d(std::span<const float> values, size_t width, size_t height,
+                               std::span<const float> kernel, size_t kernelWidth, size_t kernelHeight,
+                               ConvolutionMode mode = ConvolutionMode::Full);
+
+} // namespace fourier
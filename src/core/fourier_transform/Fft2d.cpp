@@ -0,0 +1,189 @@
+#include "Fft2d.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <glm/ext.hpp>
+
+namespace fourier {
+
+/*
+ * Transposing goes through blocks of this many rows and columns,
+ * 32 x 32 complex floats fill 8 KiB, so that the input and the output block both stay in the L1 cache.
+ */
+constexpr size_t TRANSPOSE_BLOCK_SIZE = 32;
+
+/*
+ * The number of columns that are transposed and transformed together.
+ * More columns make the reads of the grid longer, but the buffer of a strip then needs more of the cache.
+ */
+constexpr size_t COLUMN_STRIP_WIDTH = 16;
+
+namespace {
+
+/*
+ * output[column * outputStride + row] = input[row * inputStride + column], block by block,
+ * so that neither the reads nor the writes jump through the whole grid for every value.
+ */
+void transpose(const std::complex<float> *input, size_t inputStride, std::complex<float> *output,
+               size_t outputStride, size_t rows, size_t columns) {
+    for (size_t rowBlock = 0; rowBlock < rows; rowBlock += TRANSPOSE_BLOCK_SIZE) {
+        const auto rowEnd = std::min(rows, rowBlock + TRANSPOSE_BLOCK_SIZE);
+        for (size_t columnBlock = 0; columnBlock < columns; columnBlock += TRANSPOSE_BLOCK_SIZE) {
+            const auto columnEnd = std::min(columns, columnBlock + TRANSPOSE_BLOCK_SIZE);
+            for (size_t row = rowBlock; row < rowEnd; row++) {
+                for (size_t column = columnBlock; column < columnEnd; column++) {
+                    output[column * outputStride + row] = input[row * inputStride + column];
+                }
+            }
+        }
+    }
+}
+
+// transforms every column of the row-major width x height grid in place
+template <bool INVERSE>
+void transformColumns(const FftPlan &plan, std::span<std::complex<float>> values, size_t width, size_t height) {
+    const auto stripCount = static_cast<int>((width + COLUMN_STRIP_WIDTH - 1) / COLUMN_STRIP_WIDTH);
+#pragma omp parallel
+    {
+        auto strip = std::vector<std::complex<float>>(COLUMN_STRIP_WIDTH * height);
+#pragma omp for
+        for (int stripIndex = 0; stripIndex < stripCount; stripIndex++) {
+            const auto firstColumn = stripIndex * COLUMN_STRIP_WIDTH;
+            const auto columnCount = std::min(COLUMN_STRIP_WIDTH, width - firstColumn);
+            transpose(values.data() + firstColumn, width, strip.data(), height, height, columnCount);
+            for (size_t column = 0; column < columnCount; column++) {
+                const auto data = std::span(strip).subspan(column * height, height);
+                if constexpr (INVERSE) {
+                    plan.inverse(data);
+                } else {
+                    plan.forward(data);
+                }
+            }
+            transpose(strip.data(), height, values.data() + firstColumn, width, columnCount, height);
+        }
+    }
+}
+
+// e^(-2 pi^2 sigma^2 f^2), the transform of a gaussian, for the frequencies of the bins of a transform of the size
+std::vector<float> gaussianResponse(size_t binCount, size_t size, float sigma) {
+    auto response = std::vector<float>(binCount);
+    const auto factor = -2.0 * glm::pi<double>() * glm::pi<double>() * sigma * sigma;
+    for (size_t bin = 0; bin < binCount; bin++) {
+        // the bins of the upper half are the negative frequencies
+        const auto frequency = static_cast<double>(std::min(bin, size - bin)) / static_cast<double>(size);
+        response[bin] = static_cast<float>(std::exp(factor * frequency * frequency));
+    }
+    return response;
+}
+
+} // namespace
+
+RealFft2dPlan::RealFft2dPlan(size_t width, size_t height) : rowPlan(width), columnPlan(height) {}
+
+bool RealFft2dPlan::forward(std::span<const float> values, std::span<std::complex<float>> bins) const {
+    if (!isValid() || values.size() != width() * height() || bins.size() != binCount()) {
+        std::cerr << "2D real FFT plan of size " << width() << "x" << height() << " can not transform "
+                  << values.size() << " values into " << bins.size() << " bins" << std::endl;
+        return false;
+    }
+
+    const auto rowWidth = width();
+    const auto rowBinCount = binWidth();
+#pragma omp parallel for
+    for (int y = 0; y < static_cast<int>(height()); y++) {
+        rowPlan.forward(values.subspan(y * rowWidth, rowWidth), bins.subspan(y * rowBinCount, rowBinCount));
+    }
+    transformColumns<false>(columnPlan, bins, rowBinCount, height());
+    return true;
+}
+
+bool RealFft2dPlan::inverse(std::span<std::complex<float>> bins, std::span<float> values) const {
+    if (!isValid() || bins.size() != binCount() || values.size() != width() * height()) {
+        std::cerr << "2D real FFT plan of size " << width() << "x" << height() << " can not transform "
+                  << bins.size() << " bins into " << values.size() << " values" << std::endl;
+        return false;
+    }
+
+    const auto rowWidth = width();
+    const auto rowBinCount = binWidth();
+    transformColumns<true>(columnPlan, bins, rowBinCount, height());
+#pragma omp parallel for
+    for (int y = 0; y < static_cast<int>(height()); y++) {
+        rowPlan.inverse(bins.subspan(y * rowBinCount, rowBinCount), values.subspan(y * rowWidth, rowWidth));
+    }
+    return true;
+}
+
+const RealFft2dPlan &cachedRealFft2dPlan(size_t width, size_t height) {
+    // one cache per thread like the 1D plans, sizes are pairs, so they are ordered instead of hashed
+    thread_local std::map<std::pair<size_t, size_t>, RealFft2dPlan> plans = {};
+    const auto key = std::make_pair(width, height);
+    auto itr = plans.find(key);
+    if (itr == plans.end()) {
+        itr = plans.emplace(key, RealFft2dPlan(width, height)).first;
+    }
+    return itr->second;
+}
+
+bool gaussianBlur(std::span<float> values, size_t width, size_t height, float sigma) {
+    if (values.size() != width * height || sigma < 0.0F) {
+        std::cerr << "Can not blur " << values.size() << " values as " << width << "x" << height
+                  << " grid with sigma " << sigma << std::endl;
+        return false;
+    }
+    if (values.empty()) {
+        return true;
+    }
+
+    const auto &plan = cachedRealFft2dPlan(width, height);
+    auto bins = std::vector<std::complex<float>>(plan.binCount());
+    if (!plan.forward(values, bins)) {
+        return false;
+    }
+
+    // the gaussian is separable, divided by the size, because the inverse transform is not
+    const auto rowBinCount = plan.binWidth();
+    auto rowResponse = gaussianResponse(rowBinCount, width, sigma);
+    const auto scale = 1.0F / static_cast<float>(width * height);
+    for (auto &response : rowResponse) {
+        response *= scale;
+    }
+    const auto columnResponse = gaussianResponse(height, height, sigma);
+#pragma omp parallel for
+    for (int y = 0; y < static_cast<int>(height); y++) {
+        for (size_t x = 0; x < rowBinCount; x++) {
+            bins[y * rowBinCount + x] *= columnResponse[y] * rowResponse[x];
+        }
+    }
+
+    return plan.inverse(bins, values);
+}
+
+bool gaussianBlur(std::span<uint8_t> pixels, size_t width, size_t height, size_t channelCount, float sigma) {
+    if (channelCount == 0 || pixels.size() != width * height * channelCount) {
+        std::cerr << "Can not blur " << pixels.size() << " bytes as " << width << "x" << height << " pixels with "
+                  << channelCount << " channels" << std::endl;
+        return false;
+    }
+
+    auto channel = std::vector<float>(width * height);
+    for (size_t c = 0; c < channelCount; c++) {
+        for (size_t i = 0; i < channel.size(); i++) {
+            channel[i] = static_cast<float>(pixels[i * channelCount + c]);
+        }
+        if (!gaussianBlur(channel, width, height, sigma)) {
+            return false;
+        }
+        for (size_t i = 0; i < channel.size(); i++) {
+            pixels[i * channelCount + c] = static_cast<uint8_t>(std::clamp(std::round(channel[i]), 0.0F, 255.0F));
+        }
+    }
+    return true;
+}
+
+} // namespace fourier
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "FftPlan.h"
+
+namespace fourier {
+
+/**
+ * 2D FFT of a real row-major grid of width x height values, e.g. a height map or one channel of an image.
+ * The rows are transformed with a real FFT, which leaves width / 2 + 1 bins per row,
+ * the columns of those bins are then transformed with a complex FFT.
+ * The columns are transformed in strips: each strip is transposed block by block into a buffer of the thread,
+ * so that its columns are contiguous, and transposed back afterwards.
+ * Rows and strips are transformed in parallel.
+ */
+class RealFft2dPlan {
+  public:
+    /**
+     * width and height have to be at least 1, otherwise the plan is invalid and all transforms fail.
+     */
+    RealFft2dPlan(size_t width, size_t height);
+
+    size_t width() const { return rowPlan.size(); }
+    size_t height() const { return columnPlan.size(); }
+    // the number of bins per row
+    size_t binWidth() const { return rowPlan.binCount(); }
+    size_t binCount() const { return binWidth() * height(); }
+    bool isValid() const { return rowPlan.isValid() && columnPlan.isValid(); }
+
+    /**
+     * Transforms width x height values into binWidth x height bins, which are stored row by row as well:
+     * X[ky][kx] = sum(x[y][x] * e^(-2 pi i (kx x / width + ky y / height))) for kx in [0, binWidth).
+     * The missing bins are the complex conjugates of X[-ky][-kx].
+     */
+    bool forward(std::span<const float> values, std::span<std::complex<float>> bins) const;
+
+    /**
+     * Transforms binWidth x height bins back into width x height values, without dividing by width * height.
+     * The bins are used as scratch space and are overwritten.
+     */
+    bool inverse(std::span<std::complex<float>> bins, std::span<float> values) const;
+
+  private:
+    RealFftPlan rowPlan;
+    FftPlan columnPlan;
+};
+
+/**
+ * Returns a plan of the given size, which is only created the first time it is asked for on the calling thread.
+ */
+const RealFft2dPlan &cachedRealFft2dPlan(size_t width, size_t height);
+
+/**
+ * Blurs the grid with a gaussian with a standard deviation of sigma values, by multiplying its spectrum.
+ * The grid is treated as periodic like a tiling texture, values near one edge are blurred with the opposite edge.
+ * Costs the same for every sigma, unlike a kernel that covers a few sigma.
+ */
+bool gaussianBlur(std::span<float> values, size_t width, size_t height, float sigma);
+
+/**
+ * The same for interleaved 8-bit pixels with channelCount channels, like the ones of an Image.
+ * Every channel is blurred on its own.
+ */
+bool gaussianBlur(std::span<uint8_t> pixels, size_t width, size_t height, size_t channelCount, float sigma);
+
+} // namespace fourier
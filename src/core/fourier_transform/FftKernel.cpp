@@ -0,0 +1,31 @@
+#include "FftKernel.h"
+
+#include "FftKernelImpl.h"
+#include "util/CpuFeatures.h"
+
+namespace fourier {
+
+const FftKernel &scalarFftKernel() {
+    static const FftKernel kernel = createFftKernel<ScalarLanes<float>>("Scalar");
+    return kernel;
+}
+
+const BasicFftKernel<double> &doubleFftKernel() {
+    static const BasicFftKernel<double> kernel = createFftKernel<ScalarLanes<double>>("Scalar double");
+    return kernel;
+}
+
+const FftKernel &bestFftKernel() {
+    static const FftKernel &kernel = []() -> const FftKernel & {
+        if (avx2FftKernel() != nullptr && cpuSupportsAvx2() && cpuSupportsFma()) {
+            return *avx2FftKernel();
+        }
+        if (sse3FftKernel() != nullptr && cpuSupportsSse3()) {
+            return *sse3FftKernel();
+        }
+        return scalarFftKernel();
+    }();
+    return kernel;
+}
+
+} // namespace fourier
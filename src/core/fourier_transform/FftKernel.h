@@ -0,0 +1,54 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <type_traits>
+
+namespace fourier {
+
+/**
+ * The butterfly passes of an in-place, decimation-in-time FFT whose input is already in bit-reversed order.
+ * A radix-4 pass combines the two radix-2 stages with butterflies of half size m and 2m,
+ * so that the data is only loaded and stored once for both of them.
+ * The twiddles are the ones of FftPlan: the twiddles of the stage with butterflies of half size m start at m - 1.
+ * size can be smaller than the size of the transform, which is used to run the small stages block by block.
+ */
+template <typename T> struct BasicFftKernel {
+    using Pass = void (*)(std::complex<T> *values, size_t size, size_t m, const std::complex<T> *twiddles);
+
+    const char *name = "";
+    Pass radix4Forward = nullptr;
+    Pass radix4Inverse = nullptr;
+};
+
+using FftKernel = BasicFftKernel<float>;
+
+const FftKernel &scalarFftKernel();
+
+/**
+ * The SIMD kernels live in their own translation units, which are compiled for the matching instruction set.
+ * They return nullptr, if the build does not support them.
+ */
+const FftKernel *sse3FftKernel();
+const FftKernel *avx2FftKernel();
+
+/**
+ * The fastest kernel the CPU the program is running on supports, chosen on the first call.
+ */
+const FftKernel &bestFftKernel();
+
+/**
+ * Double precision only has scalar butterflies, it is used where the precision matters more than the speed.
+ */
+const BasicFftKernel<double> &doubleFftKernel();
+
+// the kernel that plans of the precision T use, if they are not given one
+template <typename T> const BasicFftKernel<T> &defaultFftKernel() {
+    if constexpr (std::is_same_v<T, double>) {
+        return doubleFftKernel();
+    } else {
+        return bestFftKernel();
+    }
+}
+
+} // namespace fourier
@@ -0,0 +1,61 @@
+#include "FftKernel.h"
+
+// this file is compiled with AVX2 and FMA enabled on x86 (see CMakeLists.txt), MSVC implies FMA with /arch:AVX2
+#if defined(__AVX2__) && (defined(__FMA__) || defined(_MSC_VER))
+#define FOURIER_AVX2_KERNEL 1
+#endif
+
+#ifdef FOURIER_AVX2_KERNEL
+
+#include <immintrin.h>
+
+#include "FftKernelImpl.h"
+
+namespace fourier {
+
+namespace {
+
+// four interleaved complex numbers
+struct Avx2Lanes {
+    using Scalar = float;
+    static constexpr size_t COUNT = 4;
+    __m256 v;
+
+    static Avx2Lanes load(const std::complex<float> *p) {
+        return {_mm256_loadu_ps(reinterpret_cast<const float *>(p))};
+    }
+    void store(std::complex<float> *p) const { _mm256_storeu_ps(reinterpret_cast<float *>(p), v); }
+
+    friend Avx2Lanes operator+(const Avx2Lanes &l, const Avx2Lanes &r) { return {_mm256_add_ps(l.v, r.v)}; }
+    friend Avx2Lanes operator-(const Avx2Lanes &l, const Avx2Lanes &r) { return {_mm256_sub_ps(l.v, r.v)}; }
+
+    Avx2Lanes multiply(const Avx2Lanes &w) const {
+        const __m256 swapped = _mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1));
+        return {_mm256_fmaddsub_ps(v, _mm256_moveldup_ps(w.v), _mm256_mul_ps(swapped, _mm256_movehdup_ps(w.v)))};
+    }
+    Avx2Lanes conj() const { return {_mm256_xor_ps(v, imaginarySigns())}; }
+    Avx2Lanes timesMinusI() const {
+        return {_mm256_xor_ps(_mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1)), imaginarySigns())};
+    }
+    Avx2Lanes timesI() const { return {_mm256_xor_ps(_mm256_permute_ps(v, _MM_SHUFFLE(2, 3, 0, 1)), realSigns())}; }
+
+    static __m256 imaginarySigns() { return _mm256_set_ps(-0.0F, 0.0F, -0.0F, 0.0F, -0.0F, 0.0F, -0.0F, 0.0F); }
+    static __m256 realSigns() { return _mm256_set_ps(0.0F, -0.0F, 0.0F, -0.0F, 0.0F, -0.0F, 0.0F, -0.0F); }
+};
+
+} // namespace
+
+const FftKernel *avx2FftKernel() {
+    static const FftKernel kernel = createFftKernel<Avx2Lanes>("AVX2");
+    return &kernel;
+}
+
+} // namespace fourier
+
+#else
+
+namespace fourier {
+const FftKernel *avx2FftKernel() { return nullptr; }
+} // namespace fourier
+
+#endif
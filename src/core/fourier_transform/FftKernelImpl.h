@@ -0,0 +1,107 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+
+#include "FftKernel.h"
+
+namespace fourier {
+
+/*
+ * This header is included by translation units that are compiled for different instruction sets.
+ * Everything in it has internal linkage, otherwise the linker could pick e.g. the AVX2 build of a function
+ * for all of its callers, which would crash on CPUs without AVX2.
+ * That includes the inline functions of the standard library: the operators and functions of std::complex are
+ * emitted as weak symbols when they are not inlined (e.g. in debug builds), so they are not used here at all.
+ */
+namespace {
+
+// the scalar counterpart of the SIMD lanes, every operation works on a single complex number
+template <typename T> struct ScalarLanes {
+    using Scalar = T;
+    static constexpr size_t COUNT = 1;
+    T re;
+    T im;
+
+    // std::complex<T> is laid out as an array of its real and its imaginary part
+    static ScalarLanes load(const std::complex<T> *p) {
+        const auto *parts = reinterpret_cast<const T *>(p);
+        return {parts[0], parts[1]};
+    }
+    void store(std::complex<T> *p) const {
+        auto *parts = reinterpret_cast<T *>(p);
+        parts[0] = re;
+        parts[1] = im;
+    }
+
+    friend ScalarLanes operator+(const ScalarLanes &l, const ScalarLanes &r) { return {l.re + r.re, l.im + r.im}; }
+    friend ScalarLanes operator-(const ScalarLanes &l, const ScalarLanes &r) { return {l.re - r.re, l.im - r.im}; }
+
+    // written out, because std::complex has to handle inf and nan in multiplications and is much slower
+    ScalarLanes multiply(const ScalarLanes &w) const { return {re * w.re - im * w.im, re * w.im + im * w.re}; }
+    ScalarLanes conj() const { return {re, -im}; }
+    ScalarLanes timesMinusI() const { return {im, -re}; }
+    ScalarLanes timesI() const { return {-im, re}; }
+};
+
+template <typename Lanes, bool INVERSE, typename Complex = std::complex<typename Lanes::Scalar>>
+inline void radix4Butterfly(Complex *x0, Complex *x1, Complex *x2, Complex *x3, const Complex *w1, const Complex *w2) {
+    auto twiddle1 = Lanes::load(w1);
+    auto twiddle2 = Lanes::load(w2);
+    if constexpr (INVERSE) {
+        twiddle1 = twiddle1.conj();
+        twiddle2 = twiddle2.conj();
+    }
+
+    // first stage: (x0, x1) and (x2, x3) with the twiddles of half size m
+    const auto a0 = Lanes::load(x0);
+    const auto t1 = Lanes::load(x1).multiply(twiddle1);
+    const auto a2 = Lanes::load(x2);
+    const auto t3 = Lanes::load(x3).multiply(twiddle1);
+    const auto b0 = a0 + t1;
+    const auto b1 = a0 - t1;
+    const auto b2 = a2 + t3;
+    const auto b3 = a2 - t3;
+
+    // second stage: (b0, b2) and (b1, b3) with the twiddles of half size 2m,
+    // the twiddle of b3 is the one of b2 rotated by a quarter turn
+    const auto u2 = b2.multiply(twiddle2);
+    const auto u3 = INVERSE ? b3.multiply(twiddle2).timesI() : b3.multiply(twiddle2).timesMinusI();
+    (b0 + u2).store(x0);
+    (b1 + u3).store(x1);
+    (b0 - u2).store(x2);
+    (b1 - u3).store(x3);
+}
+
+template <typename Lanes, bool INVERSE, typename Complex = std::complex<typename Lanes::Scalar>>
+void radix4Pass(Complex *values, size_t size, size_t m, const Complex *twiddles) {
+    // the butterflies that are left over when m is not a multiple of the number of lanes
+    using Remainder = ScalarLanes<typename Lanes::Scalar>;
+    const auto *w1 = twiddles + m - 1;
+    const auto *w2 = twiddles + 2 * m - 1;
+    for (size_t start = 0; start < size; start += 4 * m) {
+        auto *x0 = values + start;
+        auto *x1 = x0 + m;
+        auto *x2 = x1 + m;
+        auto *x3 = x2 + m;
+        size_t j = 0;
+        for (; j + Lanes::COUNT <= m; j += Lanes::COUNT) {
+            radix4Butterfly<Lanes, INVERSE>(x0 + j, x1 + j, x2 + j, x3 + j, w1 + j, w2 + j);
+        }
+        for (; j < m; j++) {
+            radix4Butterfly<Remainder, INVERSE>(x0 + j, x1 + j, x2 + j, x3 + j, w1 + j, w2 + j);
+        }
+    }
+}
+
+template <typename Lanes> BasicFftKernel<typename Lanes::Scalar> createFftKernel(const char *name) {
+    BasicFftKernel<typename Lanes::Scalar> result = {};
+    result.name = name;
+    result.radix4Forward = &radix4Pass<Lanes, false>;
+    result.radix4Inverse = &radix4Pass<Lanes, true>;
+    return result;
+}
+
+} // namespace
+
+} // namespace fourier
@@ -0,0 +1,60 @@
+#include "FftKernel.h"
+
+// MSVC does not define __SSE3__, but always allows SSE3 intrinsics on x64
+#if defined(__SSE3__) || (defined(_MSC_VER) && defined(_M_X64))
+#define FOURIER_SSE3_KERNEL 1
+#endif
+
+#ifdef FOURIER_SSE3_KERNEL
+
+#include <pmmintrin.h>
+
+#include "FftKernelImpl.h"
+
+namespace fourier {
+
+namespace {
+
+// two interleaved complex numbers
+struct Sse3Lanes {
+    using Scalar = float;
+    static constexpr size_t COUNT = 2;
+    __m128 v;
+
+    static Sse3Lanes load(const std::complex<float> *p) { return {_mm_loadu_ps(reinterpret_cast<const float *>(p))}; }
+    void store(std::complex<float> *p) const { _mm_storeu_ps(reinterpret_cast<float *>(p), v); }
+
+    friend Sse3Lanes operator+(const Sse3Lanes &l, const Sse3Lanes &r) { return {_mm_add_ps(l.v, r.v)}; }
+    friend Sse3Lanes operator-(const Sse3Lanes &l, const Sse3Lanes &r) { return {_mm_sub_ps(l.v, r.v)}; }
+
+    Sse3Lanes multiply(const Sse3Lanes &w) const {
+        const __m128 swapped = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+        return {_mm_addsub_ps(_mm_mul_ps(v, _mm_moveldup_ps(w.v)), _mm_mul_ps(swapped, _mm_movehdup_ps(w.v)))};
+    }
+    Sse3Lanes conj() const { return {_mm_xor_ps(v, _mm_set_ps(-0.0F, 0.0F, -0.0F, 0.0F))}; }
+    Sse3Lanes timesMinusI() const {
+        const __m128 swapped = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+        return {_mm_xor_ps(swapped, _mm_set_ps(-0.0F, 0.0F, -0.0F, 0.0F))};
+    }
+    Sse3Lanes timesI() const {
+        const __m128 swapped = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+        return {_mm_xor_ps(swapped, _mm_set_ps(0.0F, -0.0F, 0.0F, -0.0F))};
+    }
+};
+
+} // namespace
+
+const FftKernel *sse3FftKernel() {
+    static const FftKernel kernel = createFftKernel<Sse3Lanes>("SSE3");
+    return &kernel;
+}
+
+} // namespace fourier
+
+#else
+
+namespace fourier {
+const FftKernel *sse3FftKernel() { return nullptr; }
+} // namespace fourier
+
+#endif
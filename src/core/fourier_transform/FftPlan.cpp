@@ -0,0 +1,582 @@
+#include "FftPlan.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <iostream>
+#include <unordered_map>
+
+#include <glm/ext.hpp>
+
+namespace fourier {
+
+namespace {
+
+// written out, because std::complex has to handle inf and nan in multiplications and is much slower
+template <typename T> std::complex<T> multiply(const std::complex<T> &a, const std::complex<T> &b) {
+    return {a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real()};
+}
+
+} // namespace
+
+/*
+ * Number of complex values whose stages are computed together, before moving on to the next block.
+ * 4096 values are 32 KiB, which fits into the L1 cache of most CPUs.
+ */
+constexpr size_t FFT_BLOCK_SIZE = 4096;
+
+/*
+ * Sizes with at least this many bits are bit-reversed in tiles of 2^TILE_BITS x 2^TILE_BITS values.
+ * Below that, the list of swaps is small enough to stay in the cache.
+ */
+constexpr unsigned int TILED_BIT_REVERSAL_MIN_BITS = 16;
+constexpr unsigned int TILE_BITS = 5;
+
+namespace {
+
+/*
+ * Radices of the mixed-radix transform, sizes with other prime factors use Bluestein's algorithm.
+ * The butterflies of a stage with radix p need up to p * p multiplications, so bigger radices would not pay off.
+ * 4 comes first, because its butterflies only need additions.
+ */
+constexpr std::array<uint32_t, 5> MIXED_RADICES = {4, 2, 3, 5, 7};
+
+uint32_t reverseBits(uint32_t value, unsigned int bitCount) {
+    uint32_t result = 0;
+    for (unsigned int bit = 0; bit < bitCount; bit++) {
+        result |= ((value >> bit) & 1) << (bitCount - 1 - bit);
+    }
+    return result;
+}
+
+// the radices size is made of, or an empty list if size has a prime factor that is not one of MIXED_RADICES
+std::vector<uint32_t> factorize(size_t size) {
+    std::vector<uint32_t> result = {};
+    for (const auto radix : MIXED_RADICES) {
+        while (size % radix == 0) {
+            result.push_back(radix);
+            size /= radix;
+        }
+    }
+    if (size != 1) {
+        return {};
+    }
+    return result;
+}
+
+// e^(-2 pi i numerator / denominator), computed in double, so that the error does not grow with the size
+template <typename T> std::complex<T> unitRoot(uint64_t numerator, uint64_t denominator) {
+    const double angle = -glm::two_pi<double>() * static_cast<double>(numerator) / static_cast<double>(denominator);
+    return {static_cast<T>(std::cos(angle)), static_cast<T>(std::sin(angle))};
+}
+
+/*
+ * Scratch space for the transforms that can not work in place.
+ * There is one buffer per thread, so that transforming can stay const and does not allocate every time.
+ * Code that hands its scratch space to a complex plan has to use a different slot than the plan itself.
+ */
+constexpr unsigned int REAL_FFT_SCRATCH_SLOT = 1;
+
+template <typename T, unsigned int SLOT = 0> std::complex<T> *scratchBuffer(size_t size) {
+    thread_local std::vector<std::complex<T>> buffer = {};
+    if (buffer.size() < size) {
+        buffer.resize(size);
+    }
+    return buffer.data();
+}
+
+template <typename T> void conjugate(std::span<std::complex<T>> values) {
+    for (auto &value : values) {
+        value = std::conj(value);
+    }
+}
+
+template <typename T> std::complex<T> timesMinusI(const std::complex<T> &value) {
+    return {value.imag(), -value.real()};
+}
+
+/*
+ * Combines RADIX transforms of the given length, that follow each other in values, into one transform.
+ * The twiddles of the inputs 1 to RADIX - 1 of butterfly k start at twiddles[k * (RADIX - 1)].
+ * After the twiddles, every butterfly is a DFT of size RADIX, which is written out for the small radices.
+ */
+template <typename T, size_t RADIX>
+void mixedRadixButterflies(std::complex<T> *values, size_t length, const std::complex<T> *twiddles) {
+    // e^(-2 pi i r / RADIX), only used by the radices without a written out DFT
+    static const auto roots = [] {
+        std::array<std::complex<T>, RADIX> result = {};
+        for (size_t r = 0; r < RADIX; r++) {
+            result[r] = unitRoot<T>(r, RADIX);
+        }
+        return result;
+    }();
+    constexpr size_t HALF = RADIX / 2;
+
+    for (size_t k = 0; k < length; k++) {
+        std::array<std::complex<T>, RADIX> t = {};
+        t[0] = values[k];
+        for (size_t r = 1; r < RADIX; r++) {
+            t[r] = multiply(values[k + r * length], twiddles[k * (RADIX - 1) + r - 1]);
+        }
+
+        if constexpr (RADIX == 2) {
+            values[k] = t[0] + t[1];
+            values[k + length] = t[0] - t[1];
+        } else if constexpr (RADIX == 3) {
+            // e^(-2 pi i / 3) = -1/2 - i sqrt(3)/2
+            const auto sum = t[1] + t[2];
+            const auto middle = t[0] - static_cast<T>(0.5) * sum;
+            const auto rotated = (static_cast<T>(0.5) * std::sqrt(static_cast<T>(3.0))) * timesMinusI(t[1] - t[2]);
+            values[k] = t[0] + sum;
+            values[k + length] = middle + rotated;
+            values[k + 2 * length] = middle - rotated;
+        } else if constexpr (RADIX == 4) {
+            const auto a = t[0] + t[2];
+            const auto b = t[0] - t[2];
+            const auto c = t[1] + t[3];
+            const auto d = timesMinusI(t[1] - t[3]);
+            values[k] = a + c;
+            values[k + length] = b + d;
+            values[k + 2 * length] = a - c;
+            values[k + 3 * length] = b - d;
+        } else {
+            // odd radices: inputs r and RADIX - r are multiplied with conjugated roots,
+            // so the real and imaginary part of the root only have to be applied to their sum and difference
+            std::array<std::complex<T>, HALF + 1> sums = {};
+            std::array<std::complex<T>, HALF + 1> differences = {};
+            auto total = t[0];
+            for (size_t r = 1; r <= HALF; r++) {
+                sums[r] = t[r] + t[RADIX - r];
+                differences[r] = t[r] - t[RADIX - r];
+                total += sums[r];
+            }
+            values[k] = total;
+            for (size_t q = 1; q <= HALF; q++) {
+                auto even = t[0];
+                auto odd = std::complex<T>(0.0, 0.0);
+                for (size_t r = 1; r <= HALF; r++) {
+                    const auto &root = roots[(r * q) % RADIX];
+                    even += root.real() * sums[r];
+                    odd += root.imag() * differences[r];
+                }
+                // odd is multiplied with i, because the imaginary part of the root is applied as a real number
+                const auto iOdd = std::complex<T>(-odd.imag(), odd.real());
+                values[k + q * length] = even + iOdd;
+                values[k + (RADIX - q) * length] = even - iOdd;
+            }
+        }
+    }
+}
+
+} // namespace
+
+template <typename T>
+BasicFftPlan<T>::BasicFftPlan(size_t size, const BasicFftKernel<T> &kernel) : butterflies(&kernel) {
+    if (size == 0 || size > (1ULL << 31)) {
+        std::cerr << "FFT size has to be between 1 and 2^31, but was " << size << std::endl;
+        return;
+    }
+
+    if (!std::has_single_bit(size)) {
+        const auto radices = factorize(size);
+        if (!radices.empty()) {
+            algorithm = Algorithm::MixedRadix;
+            size_t length = size;
+            for (const auto radix : radices) {
+                length /= radix;
+                stages.push_back({radix, length, twiddles.size()});
+                // butterfly k of the stage multiplies input r with e^(-2 pi i r k / (length * radix))
+                for (size_t k = 0; k < length; k++) {
+                    for (size_t r = 1; r < radix; r++) {
+                        twiddles.push_back(unitRoot<T>(r * k, length * radix));
+                    }
+                }
+            }
+            n = size;
+            return;
+        }
+
+        // the convolution of the size chirp values with the 2 * size - 1 values of the conjugated chirp
+        algorithm = Algorithm::Bluestein;
+        convolutionPlan = std::make_shared<BasicFftPlan>(std::bit_ceil(2 * size - 1), kernel);
+        if (!convolutionPlan->isValid()) {
+            return;
+        }
+
+        // k^2 is taken modulo 2 * size, because e^(-pi i k^2 / size) repeats after that
+        chirp.reserve(size);
+        for (size_t k = 0; k < size; k++) {
+            chirp.push_back(unitRoot<T>((static_cast<uint64_t>(k) * k) % (2 * size), 2 * size));
+        }
+
+        const auto convolutionSize = convolutionPlan->size();
+        chirpSpectrum.resize(convolutionSize);
+        chirpSpectrum[0] = std::conj(chirp[0]);
+        for (size_t k = 1; k < size; k++) {
+            chirpSpectrum[k] = std::conj(chirp[k]);
+            chirpSpectrum[convolutionSize - k] = std::conj(chirp[k]);
+        }
+        convolutionPlan->forward(chirpSpectrum);
+        for (auto &value : chirpSpectrum) {
+            value /= static_cast<T>(convolutionSize);
+        }
+        n = size;
+        return;
+    }
+    n = size;
+
+    const auto logN = std::bit_width(n) - 1;
+    if (logN >= TILED_BIT_REVERSAL_MIN_BITS) {
+        const auto middleBits = logN - 2 * TILE_BITS;
+        middleReversal.resize(1ULL << middleBits);
+        for (uint32_t i = 0; i < middleReversal.size(); i++) {
+            middleReversal[i] = reverseBits(i, middleBits);
+        }
+    } else {
+        // the reversal of i is the reversal of i / 2 shifted right, with the lowest bit of i moved to the top
+        auto reversed = std::vector<uint32_t>(n, 0);
+        for (size_t i = 1; i < n; i++) {
+            reversed[i] = (reversed[i >> 1] >> 1) | ((i & 1) << (logN - 1));
+            if (i < reversed[i]) {
+                swaps.emplace_back(i, reversed[i]);
+            }
+        }
+    }
+
+    // e^(-pi i j / m) of every stage
+    twiddles.reserve(n);
+    for (size_t m = 1; m < n; m <<= 1) {
+        for (size_t j = 0; j < m; j++) {
+            twiddles.push_back(unitRoot<T>(j, 2 * m));
+        }
+    }
+}
+
+template <typename T> bool BasicFftPlan<T>::forward(std::span<std::complex<T>> data) const {
+    return transform<false>(data);
+}
+
+template <typename T> bool BasicFftPlan<T>::inverse(std::span<std::complex<T>> data) const {
+    return transform<true>(data);
+}
+
+template <typename T> template <bool INVERSE> bool BasicFftPlan<T>::transform(std::span<std::complex<T>> data) const {
+    if (!isValid() || data.size() != n) {
+        std::cerr << "FFT plan of size " << n << " can not transform " << data.size() << " values" << std::endl;
+        return false;
+    }
+
+    auto *values = data.data();
+    if (algorithm == Algorithm::PowerOfTwo) {
+        powerOfTwoTransform<INVERSE>(values);
+        return true;
+    }
+
+    // the inverse transform is the forward transform of the complex conjugates, conjugated again
+    if constexpr (INVERSE) {
+        conjugate(data);
+    }
+    if (algorithm == Algorithm::MixedRadix) {
+        mixedRadixForward(values);
+    } else {
+        bluesteinForward(values);
+    }
+    if constexpr (INVERSE) {
+        conjugate(data);
+    }
+    return true;
+}
+
+template <typename T> template <bool INVERSE> void BasicFftPlan<T>::powerOfTwoTransform(std::complex<T> *values) const {
+    bitReverse(values);
+
+    // with an odd number of stages, the first one is done separately, it only needs the twiddle 1
+    size_t firstM = 1;
+    if ((std::bit_width(n) - 1) % 2 == 1) {
+        for (size_t i = 0; i < n; i += 2) {
+            const auto a = values[i];
+            values[i] = a + values[i + 1];
+            values[i + 1] = a - values[i + 1];
+        }
+        firstM = 2;
+    }
+
+    // the butterflies of the small stages stay within blocks that fit into the cache,
+    // so all of those stages are run on one block before moving on to the next one
+    const auto pass = INVERSE ? butterflies->radix4Inverse : butterflies->radix4Forward;
+    const size_t blockSize = std::min(n, FFT_BLOCK_SIZE);
+    size_t m = firstM;
+    for (size_t block = 0; block < n; block += blockSize) {
+        for (m = firstM; 4 * m <= blockSize; m *= 4) {
+            pass(values + block, blockSize, m, twiddles.data());
+        }
+    }
+    for (; m < n; m *= 4) {
+        pass(values, n, m, twiddles.data());
+    }
+}
+
+/*
+ * Swapping single values jumps around the whole buffer, which is slow once it no longer fits into the cache.
+ * Big sizes are split into index bits [top | middle | bottom], with TILE_BITS top and bottom bits.
+ * Reversing turns them into [reversed bottom | reversed middle | reversed top],
+ * so all values with the same middle bits form a tile, which is transposed into the tile of the reversed middle bits.
+ * Each tile is read and written as rows of 2^TILE_BITS contiguous values.
+ */
+template <typename T> void BasicFftPlan<T>::bitReverse(std::complex<T> *values) const {
+    if (middleReversal.empty()) {
+        for (const auto &[i, j] : swaps) {
+            std::swap(values[i], values[j]);
+        }
+        return;
+    }
+
+    constexpr size_t TILE_SIZE = 1ULL << TILE_BITS;
+    using Tile = std::array<std::complex<T>, TILE_SIZE * TILE_SIZE>;
+    std::array<uint32_t, TILE_SIZE> tileReversal = {};
+    for (uint32_t i = 0; i < TILE_SIZE; i++) {
+        tileReversal[i] = reverseBits(i, TILE_BITS);
+    }
+
+    const size_t rowStride = n >> TILE_BITS;
+    const auto load = [values, rowStride](Tile &tile, size_t middle) {
+        for (size_t row = 0; row < TILE_SIZE; row++) {
+            const auto *source = values + row * rowStride + middle * TILE_SIZE;
+            std::copy(source, source + TILE_SIZE, tile.data() + row * TILE_SIZE);
+        }
+    };
+    const auto store = [values, rowStride, &tileReversal](const Tile &tile, size_t middle) {
+        for (size_t row = 0; row < TILE_SIZE; row++) {
+            auto *destination = values + row * rowStride + middle * TILE_SIZE;
+            for (size_t column = 0; column < TILE_SIZE; column++) {
+                destination[column] = tile[tileReversal[column] * TILE_SIZE + tileReversal[row]];
+            }
+        }
+    };
+
+    Tile tile = {};
+    Tile reversedTile = {};
+    for (size_t middle = 0; middle < middleReversal.size(); middle++) {
+        const auto reversedMiddle = middleReversal[middle];
+        if (reversedMiddle < middle) {
+            continue;
+        }
+
+        load(tile, middle);
+        if (reversedMiddle == middle) {
+            store(tile, middle);
+            continue;
+        }
+        load(reversedTile, reversedMiddle);
+        store(tile, reversedMiddle);
+        store(reversedTile, middle);
+    }
+}
+
+template <typename T> void BasicFftPlan<T>::mixedRadixForward(std::complex<T> *values) const {
+    auto *input = scratchBuffer<T>(n);
+    std::copy(values, values + n, input);
+    mixedRadixStage(values, input, 1, 0);
+}
+
+/*
+ * Decimation in time: the n / stride values input[0], input[stride], ... are split into radix interleaved sequences.
+ * Their transforms are computed recursively into consecutive parts of output and then combined in place.
+ */
+template <typename T>
+void BasicFftPlan<T>::mixedRadixStage(std::complex<T> *output, const std::complex<T> *input, size_t stride,
+                                      size_t stage) const {
+    const auto &[radix, length, twiddleOffset] = stages[stage];
+    if (length == 1) {
+        for (size_t r = 0; r < radix; r++) {
+            output[r] = input[r * stride];
+        }
+    } else {
+        for (size_t r = 0; r < radix; r++) {
+            mixedRadixStage(output + r * length, input + r * stride, stride * radix, stage + 1);
+        }
+    }
+
+    const auto *stageTwiddles = twiddles.data() + twiddleOffset;
+    switch (radix) {
+    case 2:
+        mixedRadixButterflies<T, 2>(output, length, stageTwiddles);
+        break;
+    case 3:
+        mixedRadixButterflies<T, 3>(output, length, stageTwiddles);
+        break;
+    case 4:
+        mixedRadixButterflies<T, 4>(output, length, stageTwiddles);
+        break;
+    case 5:
+        mixedRadixButterflies<T, 5>(output, length, stageTwiddles);
+        break;
+    case 7:
+        mixedRadixButterflies<T, 7>(output, length, stageTwiddles);
+        break;
+    default:
+        break;
+    }
+}
+
+/*
+ * 2 j k = j^2 + k^2 - (k - j)^2 turns the transform into a convolution with the chirp w[k] = e^(-pi i k^2 / size):
+ * X[k] = w[k] * sum(x[j] * w[j] * conj(w[k - j])).
+ * The convolution is computed with power-of-two transforms that are big enough for it not to wrap around.
+ */
+template <typename T> void BasicFftPlan<T>::bluesteinForward(std::complex<T> *values) const {
+    const auto convolutionSize = convolutionPlan->size();
+    auto *buffer = scratchBuffer<T>(convolutionSize);
+    for (size_t k = 0; k < n; k++) {
+        buffer[k] = multiply(values[k], chirp[k]);
+    }
+    std::fill(buffer + n, buffer + convolutionSize, std::complex<T>(0.0, 0.0));
+
+    const auto convolution = std::span(buffer, convolutionSize);
+    convolutionPlan->forward(convolution);
+    for (size_t k = 0; k < convolutionSize; k++) {
+        buffer[k] = multiply(buffer[k], chirpSpectrum[k]);
+    }
+    convolutionPlan->inverse(convolution);
+
+    for (size_t k = 0; k < n; k++) {
+        values[k] = multiply(buffer[k], chirp[k]);
+    }
+}
+
+template <typename T>
+BasicRealFftPlan<T>::BasicRealFftPlan(size_t size) : complexPlan(size % 2 == 0 ? size / 2 : size) {
+    if (size == 0 || !complexPlan.isValid()) {
+        // odd sizes are transformed by a complex plan of the same size instead of half of it
+        std::cerr << "Real FFT size has to be between 1 and " << (size % 2 == 0 ? "2^32" : "2^31") << ", but was "
+                  << size << std::endl;
+        return;
+    }
+    n = size;
+
+    if (n % 2 == 0) {
+        for (size_t k = 0; k <= n / 4; k++) {
+            twiddles.push_back(unitRoot<T>(k, n));
+        }
+    }
+}
+
+template <typename T>
+bool BasicRealFftPlan<T>::forward(std::span<const T> samples, std::span<std::complex<T>> bins) const {
+    if (!isValid() || samples.size() != n || bins.size() != binCount()) {
+        std::cerr << "Real FFT plan of size " << n << " can not transform " << samples.size() << " samples into "
+                  << bins.size() << " bins" << std::endl;
+        return false;
+    }
+
+    if (n % 2 == 1) {
+        auto *values = scratchBuffer<T, REAL_FFT_SCRATCH_SLOT>(n);
+        std::copy(samples.begin(), samples.end(), values);
+        complexPlan.forward(std::span<std::complex<T>>(values, n));
+        std::copy_n(values, bins.size(), bins.begin());
+        return true;
+    }
+
+    const auto half = n / 2;
+    for (size_t j = 0; j < half; j++) {
+        bins[j] = std::complex<T>(samples[2 * j], samples[2 * j + 1]);
+    }
+    complexPlan.forward(bins.first(half));
+
+    // Z is the transform of the packed samples, E and O the transforms of the even and odd samples:
+    // E[k] = (Z[k] + conj(Z[half - k])) / 2, O[k] = -i (Z[k] - conj(Z[half - k])) / 2, X[k] = E[k] + w^k O[k]
+    // bin k and bin half - k need the same two values of Z, so they are computed together in place
+    const auto z0 = bins[0];
+    bins[0] = z0.real() + z0.imag();
+    bins[half] = z0.real() - z0.imag();
+    for (size_t k = 1; k <= half / 2; k++) {
+        const auto a = bins[k];
+        const auto b = std::conj(bins[half - k]);
+        const auto even = static_cast<T>(0.5) * (a + b);
+        // -i (a - b) / 2
+        const auto odd = static_cast<T>(0.5) * std::complex<T>(a.imag() - b.imag(), b.real() - a.real());
+        const auto wOdd = multiply(twiddles[k], odd);
+        // w^(half - k) = -conj(w^k)
+        bins[k] = even + wOdd;
+        bins[half - k] = std::conj(even - wOdd);
+    }
+
+    return true;
+}
+
+template <typename T> bool BasicRealFftPlan<T>::inverse(std::span<std::complex<T>> bins, std::span<T> samples) const {
+    if (!isValid() || samples.size() != n || bins.size() != binCount()) {
+        std::cerr << "Real FFT plan of size " << n << " can not transform " << bins.size() << " bins into "
+                  << samples.size() << " samples" << std::endl;
+        return false;
+    }
+
+    if (n % 2 == 1) {
+        // the missing bins are the complex conjugates of the given ones
+        auto values = std::vector<std::complex<T>>(n);
+        std::copy(bins.begin(), bins.end(), values.begin());
+        for (size_t k = 1; k < bins.size(); k++) {
+            values[n - k] = std::conj(bins[k]);
+        }
+        complexPlan.inverse(values);
+        for (size_t j = 0; j < n; j++) {
+            samples[j] = values[j].real();
+        }
+        return true;
+    }
+
+    // the forward post-processing step in reverse, without the factor 1/2, so that the result is scaled by size
+    const auto half = n / 2;
+    const auto x0 = bins[0].real();
+    const auto xHalf = bins[half].real();
+    bins[0] = std::complex<T>(x0 + xHalf, x0 - xHalf);
+    for (size_t k = 1; k <= half / 2; k++) {
+        const auto a = bins[k];
+        const auto b = std::conj(bins[half - k]);
+        const auto even = a + b;
+        const auto odd = multiply(a - b, std::conj(twiddles[k]));
+        // i * odd
+        const auto iOdd = std::complex<T>(-odd.imag(), odd.real());
+        bins[k] = even + iOdd;
+        bins[half - k] = std::conj(even - iOdd);
+    }
+    complexPlan.inverse(bins.first(half));
+
+    for (size_t j = 0; j < half; j++) {
+        samples[2 * j] = bins[j].real();
+        samples[2 * j + 1] = bins[j].imag();
+    }
+
+    return true;
+}
+
+template <typename T> const BasicFftPlan<T> &cachedPlan(size_t size) {
+    // one cache per thread, so that looking up a plan never has to be synchronized
+    thread_local std::unordered_map<size_t, BasicFftPlan<T>> plans = {};
+    auto itr = plans.find(size);
+    if (itr == plans.end()) {
+        itr = plans.emplace(size, BasicFftPlan<T>(size)).first;
+    }
+    return itr->second;
+}
+
+template <typename T> const BasicRealFftPlan<T> &cachedRealPlan(size_t size) {
+    thread_local std::unordered_map<size_t, BasicRealFftPlan<T>> plans = {};
+    auto itr = plans.find(size);
+    if (itr == plans.end()) {
+        itr = plans.emplace(size, BasicRealFftPlan<T>(size)).first;
+    }
+    return itr->second;
+}
+
+template class BasicFftPlan<float>;
+template class BasicFftPlan<double>;
+template class BasicRealFftPlan<float>;
+template class BasicRealFftPlan<double>;
+template const FftPlan &cachedPlan<float>(size_t size);
+template const DoubleFftPlan &cachedPlan<double>(size_t size);
+template const RealFftPlan &cachedRealPlan<float>(size_t size);
+template const DoubleRealFftPlan &cachedRealPlan<double>(size_t size);
+
+} // namespace fourier
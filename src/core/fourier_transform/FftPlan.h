@@ -0,0 +1,137 @@
+#pragma once
+
+#include <complex>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "FftKernel.h"
+
+namespace fourier {
+
+/**
+ * Everything a complex FFT of one size needs that does not depend on the input:
+ * the bit-reversal permutation and the twiddle factors of every stage.
+ * A plan is created once and can then transform any number of caller-owned buffers in place.
+ * Transforming is const, so one plan can be shared between threads.
+ * T is the precision of the values and the twiddles, float or double. Only float has SIMD kernels,
+ * double is for the callers that need the precision, e.g. long sums or values that are subtracted afterwards.
+ * How a size is transformed depends on its prime factors:
+ * - powers of two use radix-4 butterflies computed by the fastest kernel the CPU supports (see FftKernel.h)
+ * - sizes without prime factors bigger than 7 use a mixed-radix transform
+ * - all other sizes use Bluestein's algorithm, which turns the transform into a convolution,
+ *   that is computed with power-of-two transforms
+ */
+template <typename T> class BasicFftPlan {
+  public:
+    /**
+     * size has to be at least 1, otherwise the plan is invalid and all transforms fail.
+     */
+    explicit BasicFftPlan(size_t size, const BasicFftKernel<T> &kernel = defaultFftKernel<T>());
+
+    size_t size() const { return n; }
+    bool isValid() const { return n != 0; }
+    const BasicFftKernel<T> &kernel() const { return *butterflies; }
+
+    /**
+     * X[k] = sum(x[j] * e^(-2 pi i j k / N))
+     */
+    bool forward(std::span<std::complex<T>> data) const;
+
+    /**
+     * x[j] = sum(X[k] * e^(2 pi i j k / N)), without dividing by N.
+     */
+    bool inverse(std::span<std::complex<T>> data) const;
+
+  private:
+    enum class Algorithm {
+        PowerOfTwo,
+        MixedRadix,
+        Bluestein,
+    };
+
+    // combines radix transforms of the given length, from the outermost stage to the innermost one
+    struct Stage {
+        uint32_t radix;
+        size_t length;
+        size_t twiddleOffset;
+    };
+
+    template <bool INVERSE> bool transform(std::span<std::complex<T>> data) const;
+    template <bool INVERSE> void powerOfTwoTransform(std::complex<T> *values) const;
+    void bitReverse(std::complex<T> *values) const;
+    void mixedRadixForward(std::complex<T> *values) const;
+    void mixedRadixStage(std::complex<T> *output, const std::complex<T> *input, size_t stride,
+                         size_t stage) const;
+    void bluesteinForward(std::complex<T> *values) const;
+
+    size_t n = 0;
+    Algorithm algorithm = Algorithm::PowerOfTwo;
+    const BasicFftKernel<T> *butterflies = nullptr;
+    // small sizes: only the pairs that actually have to be swapped, each one is listed once
+    std::vector<std::pair<uint32_t, uint32_t>> swaps = {};
+    // big sizes are permuted tile by tile (see bitReverse), this is the reversal of the bits between the tile bits
+    std::vector<uint32_t> middleReversal = {};
+    // power of two: the twiddles of the stage with butterflies of half size m start at m - 1
+    // mixed radix: the twiddles of every stage start at its twiddleOffset
+    std::vector<std::complex<T>> twiddles = {};
+    std::vector<Stage> stages = {};
+    // Bluestein: e^(-pi i k^2 / size) for k in [0, size)
+    std::vector<std::complex<T>> chirp = {};
+    // Bluestein: the transform of the conjugated chirp, already divided by the size of the convolution
+    std::vector<std::complex<T>> chirpSpectrum = {};
+    std::shared_ptr<const BasicFftPlan> convolutionPlan = nullptr;
+};
+
+using FftPlan = BasicFftPlan<float>;
+using DoubleFftPlan = BasicFftPlan<double>;
+
+/**
+ * FFT of real input, which only needs a complex FFT of half the size.
+ * The even samples are packed into the real and the odd samples into the imaginary parts,
+ * a post-processing pass then separates the two halves again.
+ * Odd sizes can not be packed like that and use a complex FFT of the full size.
+ * Only the bins 0 to size / 2 are computed, the others are their complex conjugates.
+ */
+template <typename T> class BasicRealFftPlan {
+  public:
+    /**
+     * size has to be at least 1, otherwise the plan is invalid and all transforms fail.
+     */
+    explicit BasicRealFftPlan(size_t size);
+
+    size_t size() const { return n; }
+    size_t binCount() const { return n / 2 + 1; }
+    bool isValid() const { return n != 0; }
+
+    /**
+     * Transforms size samples into binCount bins.
+     */
+    bool forward(std::span<const T> samples, std::span<std::complex<T>> bins) const;
+
+    /**
+     * Transforms binCount bins back into size samples, without dividing by size.
+     * The bins are used as scratch space and are overwritten.
+     */
+    bool inverse(std::span<std::complex<T>> bins, std::span<T> samples) const;
+
+  private:
+    size_t n = 0;
+    // size / 2 for even sizes and size for odd ones
+    BasicFftPlan<T> complexPlan;
+    // e^(-2 pi i k / size) for k in [0, size / 4]
+    std::vector<std::complex<T>> twiddles = {};
+};
+
+using RealFftPlan = BasicRealFftPlan<float>;
+using DoubleRealFftPlan = BasicRealFftPlan<double>;
+
+/**
+ * Returns a plan of the given size, which is only created the first time it is asked for on the calling thread.
+ */
+template <typename T = float> const BasicFftPlan<T> &cachedPlan(size_t size);
+template <typename T = float> const BasicRealFftPlan<T> &cachedRealPlan(size_t size);
+
+} // namespace fourier
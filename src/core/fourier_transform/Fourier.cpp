@@ -1,99 +1,30 @@
 #include "Fourier.h"
 
+#include "FftPlan.h"
+
+#include <algorithm>
+#include <cmath>
 #include <glm/ext.hpp>
+#include <iostream>
 
 #define _USE_MATH_DEFINES
 #include <math.h>
 
 namespace fourier {
 
-void internalFFT(float *fftBuffer, long fftFrameSize, long sign) {
-    float wr, wi, arg, *p1, *p2, temp;
-    float tr, ti, ur, ui, *p1r, *p1i, *p2r, *p2i;
-    long i, bitm, j, le, le2, k, logN;
-    logN = (long)(log(fftFrameSize) / log(2.) + .5);
-
-    for (i = 2; i < 2 * fftFrameSize - 2; i += 2) {
-        for (bitm = 2, j = 0; bitm < 2 * fftFrameSize; bitm <<= 1) {
-            if (i & bitm)
-                j++;
-            j <<= 1;
-        }
-        if (i < j) {
-            p1 = fftBuffer + i;
-            p2 = fftBuffer + j;
-            temp = *p1;
-            *(p1++) = *p2;
-            *(p2++) = temp;
-            temp = *p1;
-            *p1 = *p2;
-            *p2 = temp;
-        }
-    }
-
-    for (k = 0, le = 2; k < logN; k++) {
-        le <<= 1;
-        le2 = le >> 1;
-        ur = 1.0;
-        ui = 0.0;
-        arg = M_PI / (le2 >> 1);
-        wr = cos(arg);
-        wi = sign * sin(arg);
-        for (j = 0; j < le2; j += 2) {
-            p1r = fftBuffer + j;
-            p1i = p1r + 1;
-            p2r = p1r + le2;
-            p2i = p2r + 1;
-            for (i = j; i < 2 * fftFrameSize; i += le) {
-                tr = *p2r * ur - *p2i * ui;
-                ti = *p2r * ui + *p2i * ur;
-                *p2r = *p1r - tr;
-                *p2i = *p1i - ti;
-                *p1r += tr;
-                *p1i += ti;
-                p1r += le;
-                p1i += le;
-                p2r += le;
-                p2i += le;
-            }
-            tr = ur * wr - ui * wi;
-            ui = ur * wi + ui * wr;
-            ur = tr;
-        }
-    }
-}
-
-long roundUpToPowerOfTwo(long num) {
-    long currentPower = 2;
-    while (true) {
-        if (num < currentPower) {
-            return currentPower;
-        }
-        currentPower *= 2;
-    }
-}
-
 std::vector<DataPoint> fft(const std::vector<float> &inputData, unsigned int sampleRate) {
-    const auto fftFrameSize = roundUpToPowerOfTwo(inputData.size());
-    float *fftBuffer = reinterpret_cast<float *>(std::malloc(2 * fftFrameSize * sizeof(float)));
-    const auto sign = -1L;
-
-    for (unsigned int i = 0; i < fftFrameSize; i++) {
-        if (i < inputData.size()) {
-            fftBuffer[i * 2] = inputData[i];
-        } else {
-            fftBuffer[i * 2] = 0.0F;
-        }
-        fftBuffer[i * 2 + 1] = 0.0F;
+    if (inputData.empty()) {
+        return {};
     }
 
-    internalFFT(fftBuffer, fftFrameSize, sign);
+    auto fftBuffer = std::vector<std::complex<float>>(inputData.size() / 2 + 1);
+    fft<float>(inputData, fftBuffer);
 
     auto result = std::vector<DataPoint>();
     const auto transformLength = inputData.size();
-    for (unsigned int bin = 0; bin < fftFrameSize; bin += 2) {
-        const auto cosPart = fftBuffer[bin];
-        const auto sinPart = fftBuffer[bin + 1];
+    for (unsigned int bin = 0; bin < fftBuffer.size(); bin++) {
+        const auto cosPart = fftBuffer[bin].real();
+        const auto sinPart = fftBuffer[bin].imag();
 
         const auto frequency = (static_cast<double>(bin) * static_cast<double>(sampleRate)) / transformLength;
         //        const auto magnitude = (20.0 * log10(2.0 * std::sqrt(sinPart * sinPart + cosPart * cosPart))) /
@@ -103,8 +34,28 @@ std::vector<DataPoint> fft(const std::vector<float> &inputData, unsigned int sam
         result.push_back({frequency, magnitude, phase});
     }
 
-    free(fftBuffer);
+    return result;
+}
 
+std::vector<float> ifft(const std::vector<DataPoint> &coefficients, size_t sampleCount) {
+    if (sampleCount == 0 || coefficients.size() != sampleCount / 2 + 1) {
+        std::cerr << "Can not turn " << coefficients.size() << " coefficients into " << sampleCount << " samples"
+                  << std::endl;
+        return {};
+    }
+
+    auto fftBuffer = std::vector<std::complex<float>>();
+    fftBuffer.reserve(coefficients.size());
+    for (const auto &coefficient : coefficients) {
+        const auto phase = (coefficient.phase * M_PI) / 180.0;
+        fftBuffer.push_back(std::polar(static_cast<float>(coefficient.magnitude), static_cast<float>(phase)));
+    }
+
+    auto result = std::vector<float>(sampleCount);
+    cachedRealPlan(sampleCount).inverse(fftBuffer, result);
+    for (auto &sample : result) {
+        sample /= static_cast<float>(sampleCount);
+    }
     return result;
 }
 
@@ -131,27 +82,91 @@ std::vector<DataPoint> dft(const std::vector<float> &inputData, unsigned int sam
 }
 
 std::vector<DataPoint> dft2(const std::vector<glm::vec2> &inputData, unsigned int resolution) {
-    const unsigned long N = inputData.size();
-    auto result = std::vector<DataPoint>();
+    if (inputData.empty()) {
+        return {};
+    }
 
-    int startFrequency = -1 * static_cast<int>(resolution);
-    for (int frequency = startFrequency; frequency <= static_cast<int>(resolution); frequency++) {
-        std::complex<double> sum = {0, 0};
-        for (unsigned long n = 0; n < N; n++) {
-            double angle = (glm::two_pi<double>() * static_cast<double>(frequency) * static_cast<double>(n)) /
-                           static_cast<double>(N);
-            sum += std::complex<double>(inputData[n].x, inputData[n].y) *
-                   std::complex<double>(cos(angle), -1 * sin(angle));
-        }
+    // double precision, like the direct transform this replaced
+    auto points = std::vector<std::complex<double>>();
+    points.reserve(inputData.size());
+    for (const auto &point : inputData) {
+        points.emplace_back(point.x, point.y);
+    }
+    auto coefficients = std::vector<std::complex<double>>(2 * static_cast<size_t>(resolution) + 1);
+    dft2<double>(std::span<const std::complex<double>>(points), resolution, coefficients);
 
-        double re = sum.real() / static_cast<double>(N);
-        double im = sum.imag() / static_cast<double>(N);
-        double magnitude = glm::length(glm::vec2(re, im));
+    auto result = std::vector<DataPoint>();
+    result.reserve(coefficients.size());
+    int startFrequency = -1 * static_cast<int>(resolution);
+    for (size_t i = 0; i < coefficients.size(); i++) {
+        double re = coefficients[i].real();
+        double im = coefficients[i].imag();
+        double magnitude = std::hypot(re, im);
         double phase = atan2(im, re);
-        result.push_back({static_cast<double>(frequency), magnitude, phase});
+        result.push_back({static_cast<double>(startFrequency + static_cast<int>(i)), magnitude, phase});
     }
 
     return result;
 }
 
+template <typename T> bool fft(std::span<const T> samples, std::span<std::complex<T>> bins) {
+    if (samples.empty() || bins.size() != samples.size() / 2 + 1) {
+        std::cerr << "Can not transform " << samples.size() << " samples into " << bins.size() << " bins"
+                  << std::endl;
+        return false;
+    }
+
+    // the plans handle any size, so the input is transformed as it is, without padding it
+    return cachedRealPlan<T>(samples.size()).forward(samples, bins);
+}
+
+template <typename T> bool fftMagnitudes(std::span<const T> samples, std::span<T> magnitudes) {
+    // the bins are only needed until their magnitudes are known, every thread keeps its buffer for the next call
+    thread_local std::vector<std::complex<T>> bins = {};
+    bins.resize(magnitudes.size());
+    if (!fft<T>(samples, bins)) {
+        return false;
+    }
+
+    // written out, because std::abs uses hypot, which avoids overflows, but is much slower
+    for (size_t bin = 0; bin < bins.size(); bin++) {
+        magnitudes[bin] = std::sqrt(bins[bin].real() * bins[bin].real() + bins[bin].imag() * bins[bin].imag());
+    }
+    return true;
+}
+
+template <typename T>
+bool dft2(std::span<const std::complex<T>> points, unsigned int resolution, std::span<std::complex<T>> coefficients) {
+    const auto N = points.size();
+    if (N == 0 || coefficients.size() != 2 * static_cast<size_t>(resolution) + 1) {
+        std::cerr << "Can not compute " << coefficients.size() << " coefficients of resolution " << resolution
+                  << " from " << N << " points" << std::endl;
+        return false;
+    }
+
+    thread_local std::vector<std::complex<T>> fftBuffer = {};
+    fftBuffer.assign(points.begin(), points.end());
+    cachedPlan<T>(N).forward(fftBuffer);
+
+    // sum(x[n] * e^(-2 pi i f n / N)) repeats every N frequencies, so frequency f is bin f mod N,
+    // which also holds for the frequencies beyond N / 2 that a resolution bigger than that asks for
+    const auto scale = static_cast<T>(1.0) / static_cast<T>(N);
+    const auto startFrequency = -static_cast<long>(resolution);
+    for (size_t i = 0; i < coefficients.size(); i++) {
+        const auto frequency = startFrequency + static_cast<long>(i);
+        const auto bin = ((frequency % static_cast<long>(N)) + static_cast<long>(N)) % static_cast<long>(N);
+        coefficients[i] = scale * fftBuffer[bin];
+    }
+    return true;
+}
+
+template bool fft<float>(std::span<const float> samples, std::span<std::complex<float>> bins);
+template bool fft<double>(std::span<const double> samples, std::span<std::complex<double>> bins);
+template bool fftMagnitudes<float>(std::span<const float> samples, std::span<float> magnitudes);
+template bool fftMagnitudes<double>(std::span<const double> samples, std::span<double> magnitudes);
+template bool dft2<float>(std::span<const std::complex<float>> points, unsigned int resolution,
+                          std::span<std::complex<float>> coefficients);
+template bool dft2<double>(std::span<const std::complex<double>> points, unsigned int resolution,
+                           std::span<std::complex<double>> coefficients);
+
 } // namespace fourier
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <complex>
+#include <span>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -14,7 +15,35 @@ struct DataPoint {
 };
 
 std::vector<DataPoint> fft(const std::vector<float> &inputData, unsigned int sampleRate);
+/**
+ * The inverse of fft: turns the coefficients fft returned for sampleCount samples back into the samples.
+ */
+std::vector<float> ifft(const std::vector<DataPoint> &coefficients, size_t sampleCount);
 std::vector<DataPoint> dft(const std::vector<float> &inputData, unsigned int resolution);
 std::vector<DataPoint> dft2(const std::vector<glm::vec2> &inputData, unsigned int resolution);
 
+/*
+ * The raw versions of the transforms above: they write the complex value of every bin into a span of the caller,
+ * std::complex<T> is laid out as interleaved real and imaginary parts.
+ * Unlike the DataPoint versions, they neither compute magnitude and phase (sqrt and atan2) nor allocate.
+ * T is float or double, the transform is computed in that precision.
+ */
+
+/**
+ * The bins 0 to samples.size() / 2 of the FFT of the samples, bins has to hold samples.size() / 2 + 1 values.
+ */
+template <typename T> bool fft(std::span<const T> samples, std::span<std::complex<T>> bins);
+
+/**
+ * Only the magnitudes of the same bins, which skips the atan2 of the phase.
+ */
+template <typename T> bool fftMagnitudes(std::span<const T> samples, std::span<T> magnitudes);
+
+/**
+ * The coefficients of the frequencies -resolution to resolution of the points, divided by the number of points.
+ * coefficients has to hold 2 * resolution + 1 values.
+ */
+template <typename T>
+bool dft2(std::span<const std::complex<T>> points, unsigned int resolution, std::span<std::complex<T>> coefficients);
+
 } // namespace fourier
@@ -0,0 +1,90 @@
+#include "SlidingDft.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <utility>
+
+#include <glm/ext.hpp>
+
+namespace fourier {
+
+SlidingDft::SlidingDft(size_t windowSize, std::vector<unsigned int> bins, double damping)
+    : trackedBins(std::move(bins)), history(windowSize, 0.0F) {
+    if (windowSize == 0 || damping <= 0.0 || damping > 1.0) {
+        std::cerr << "Sliding DFT needs a window of at least one sample and a damping in (0, 1], but got "
+                  << windowSize << " and " << damping << std::endl;
+        trackedBins.clear();
+        return;
+    }
+
+    const auto isOutside = [windowSize](unsigned int bin) { return bin >= windowSize; };
+    if (std::any_of(trackedBins.begin(), trackedBins.end(), isOutside)) {
+        std::cerr << "Sliding DFT bins have to be smaller than the window size " << windowSize << std::endl;
+        trackedBins.erase(std::remove_if(trackedBins.begin(), trackedBins.end(), isOutside), trackedBins.end());
+    }
+
+    oldestWeight = std::pow(damping, static_cast<double>(windowSize));
+    for (const auto bin : trackedBins) {
+        const double angle = glm::two_pi<double>() * static_cast<double>(bin) / static_cast<double>(windowSize);
+        rotations.push_back(std::polar(damping, angle));
+    }
+    values.resize(trackedBins.size());
+}
+
+void SlidingDft::push(float sample) {
+    if (history.empty()) {
+        return;
+    }
+
+    const auto change = static_cast<double>(sample) - oldestWeight * static_cast<double>(history[position]);
+    history[position] = sample;
+    position = position + 1 == history.size() ? 0 : position + 1;
+
+    // written out, because std::complex has to handle inf and nan in multiplications and is much slower
+    for (size_t i = 0; i < values.size(); i++) {
+        const auto &rotation = rotations[i];
+        const auto real = values[i].real() + change;
+        const auto imag = values[i].imag();
+        values[i] = {rotation.real() * real - rotation.imag() * imag, rotation.real() * imag + rotation.imag() * real};
+    }
+}
+
+void SlidingDft::push(std::span<const float> samples) {
+    for (const auto sample : samples) {
+        push(sample);
+    }
+}
+
+void SlidingDft::reset() {
+    std::fill(history.begin(), history.end(), 0.0F);
+    std::fill(values.begin(), values.end(), std::complex<double>(0.0, 0.0));
+    position = 0;
+}
+
+/*
+ * s(n) = x(n) + 2 cos(w) s(n - 1) - s(n - 2) only needs real multiplications.
+ * Afterwards s(N - 1) - e^(-i w) s(N - 2) = sum(x(n) * e^(i w (N - 1 - n))),
+ * which only has to be rotated back by e^(-i w (N - 1)).
+ */
+std::complex<float> goertzel(std::span<const float> samples, double bin) {
+    if (samples.empty()) {
+        return {0.0F, 0.0F};
+    }
+
+    const auto size = static_cast<double>(samples.size());
+    const double w = glm::two_pi<double>() * bin / size;
+    const double coefficient = 2.0 * std::cos(w);
+    double previous = 0.0;
+    double beforePrevious = 0.0;
+    for (const auto sample : samples) {
+        const double current = static_cast<double>(sample) + coefficient * previous - beforePrevious;
+        beforePrevious = previous;
+        previous = current;
+    }
+
+    const auto result = (previous - std::polar(1.0, -w) * beforePrevious) * std::polar(1.0, -w * (size - 1.0));
+    return std::complex<float>(result);
+}
+
+} // namespace fourier
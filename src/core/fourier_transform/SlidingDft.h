@@ -0,0 +1,63 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace fourier {
+
+/**
+ * Every value stored by a SlidingDft is multiplied with this once per sample.
+ * Rounding errors then die out after about 100000 samples instead of adding up forever,
+ * while the oldest sample of a window of 1024 samples is still weighted with 0.99.
+ */
+constexpr double SLIDING_DFT_DAMPING = 0.99999;
+
+/**
+ * Tracks a few bins of the DFT of the last windowSize samples, with O(1) work per sample and bin:
+ * X_k(n) = r e^(2 pi i k / N) (X_k(n - 1) + x(n) - r^N x(n - N)),
+ * which is sum(x(n - N + 1 + m) * e^(-2 pi i k m / N) * r^(N - m)) for m in [0, N).
+ * The damping r < 1 keeps the recursion stable, it slightly favors newer samples over older ones.
+ * Until windowSize samples were pushed, the missing ones count as 0.
+ */
+class SlidingDft {
+  public:
+    /**
+     * bins have to be smaller than windowSize, damping has to be in (0, 1].
+     */
+    SlidingDft(size_t windowSize, std::vector<unsigned int> bins, double damping = SLIDING_DFT_DAMPING);
+
+    void push(float sample);
+    void push(std::span<const float> samples);
+    // forgets all samples
+    void reset();
+
+    size_t windowSize() const { return history.size(); }
+    const std::vector<unsigned int> &bins() const { return trackedBins; }
+
+    /**
+     * The current value of bins()[index].
+     */
+    std::complex<float> value(size_t index) const { return std::complex<float>(values[index]); }
+    float magnitude(size_t index) const { return static_cast<float>(std::abs(values[index])); }
+
+  private:
+    std::vector<unsigned int> trackedBins = {};
+    // r e^(2 pi i k / N) of every tracked bin
+    std::vector<std::complex<double>> rotations = {};
+    std::vector<std::complex<double>> values = {};
+    // r^N, the weight of the sample that leaves the window
+    double oldestWeight = 1.0;
+    // the last windowSize samples, position is the oldest one
+    std::vector<float> history = {};
+    size_t position = 0;
+};
+
+/**
+ * Goertzel's algorithm: a single bin of the DFT of the samples, sum(x(n) * e^(-2 pi i bin n / N)),
+ * with one multiplication per sample. bin does not have to be a whole number.
+ */
+std::complex<float> goertzel(std::span<const float> samples, double bin);
+
+} // namespace fourier
@@ -0,0 +1,83 @@
+#include "Spectrogram.h"
+
+#include <cmath>
+#include <complex>
+#include <iostream>
+
+#include <glm/ext.hpp>
+
+#include "FftPlan.h"
+
+namespace fourier {
+
+std::vector<float> windowCoefficients(Window window, size_t size) {
+    auto result = std::vector<float>(size, 1.0F);
+    for (size_t i = 0; i < size; i++) {
+        const double x = glm::two_pi<double>() * static_cast<double>(i) / static_cast<double>(size);
+        switch (window) {
+        case Window::Rectangular:
+            break;
+        case Window::Hann:
+            result[i] = static_cast<float>(0.5 - 0.5 * std::cos(x));
+            break;
+        case Window::Hamming:
+            result[i] = static_cast<float>(0.54 - 0.46 * std::cos(x));
+            break;
+        case Window::Blackman:
+            result[i] = static_cast<float>(0.42 - 0.5 * std::cos(x) + 0.08 * std::cos(2.0 * x));
+            break;
+        }
+    }
+    return result;
+}
+
+Spectrogram stft(std::span<const float> samples, size_t frameSize, size_t hop, Window window) {
+    Spectrogram result = {};
+    if (hop == 0) {
+        std::cerr << "STFT hop has to be at least 1" << std::endl;
+        return result;
+    }
+
+    const auto &plan = cachedRealPlan(frameSize);
+    if (!plan.isValid()) {
+        return result;
+    }
+
+    result.frameSize = frameSize;
+    result.hop = hop;
+    result.binCount = plan.binCount();
+    if (samples.size() >= frameSize) {
+        result.frameCount = (samples.size() - frameSize) / hop + 1;
+    }
+    result.magnitudes.resize(result.frameCount * result.binCount);
+    result.phases.resize(result.frameCount * result.binCount);
+
+    const auto coefficients = windowCoefficients(window, frameSize);
+    const auto frameCount = static_cast<int>(result.frameCount);
+#pragma omp parallel
+    {
+        // scratch buffers of this thread, reused for all of its frames
+        auto frame = std::vector<float>(frameSize);
+        auto bins = std::vector<std::complex<float>>(plan.binCount());
+
+#pragma omp for
+        for (int f = 0; f < frameCount; f++) {
+            const auto *input = samples.data() + static_cast<size_t>(f) * hop;
+            for (size_t i = 0; i < frameSize; i++) {
+                frame[i] = input[i] * coefficients[i];
+            }
+            plan.forward(frame, bins);
+
+            auto *magnitudes = result.magnitudes.data() + static_cast<size_t>(f) * result.binCount;
+            auto *phases = result.phases.data() + static_cast<size_t>(f) * result.binCount;
+            for (size_t bin = 0; bin < bins.size(); bin++) {
+                magnitudes[bin] = std::abs(bins[bin]);
+                phases[bin] = std::arg(bins[bin]);
+            }
+        }
+    }
+
+    return result;
+}
+
+} // namespace fourier
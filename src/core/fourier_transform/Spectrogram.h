@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <vector>
+
+namespace fourier {
+
+enum class Window {
+    Rectangular,
+    Hann,
+    Hamming,
+    Blackman,
+};
+
+/**
+ * The periodic version of the window, which is the one that adds up evenly when frames overlap.
+ */
+std::vector<float> windowCoefficients(Window window, size_t size);
+
+/**
+ * Magnitude and phase of every frame of a short-time Fourier transform.
+ * Both are stored as one contiguous frames x bins matrix, one frame after the other.
+ */
+struct Spectrogram {
+    size_t frameSize = 0;
+    size_t hop = 0;
+    size_t frameCount = 0;
+    size_t binCount = 0;
+    std::vector<float> magnitudes = {};
+    // in radians
+    std::vector<float> phases = {};
+
+    float magnitude(size_t frame, size_t bin) const { return magnitudes[frame * binCount + bin]; }
+    float phase(size_t frame, size_t bin) const { return phases[frame * binCount + bin]; }
+    std::span<const float> frameMagnitudes(size_t frame) const {
+        return std::span(magnitudes).subspan(frame * binCount, binCount);
+    }
+    std::span<const float> framePhases(size_t frame) const {
+        return std::span(phases).subspan(frame * binCount, binCount);
+    }
+
+    double frequency(size_t bin, unsigned int sampleRate) const {
+        return static_cast<double>(bin) * static_cast<double>(sampleRate) / static_cast<double>(frameSize);
+    }
+};
+
+/**
+ * Transforms the frames starting at 0, hop, 2 * hop, ... that lie completely inside of the samples,
+ * each one multiplied with the window first. A frame has frameSize / 2 + 1 bins.
+ * frameSize and hop have to be at least 1, otherwise the result is empty.
+ * The frames are computed in parallel, the plan is created once and shared by all threads.
+ */
+Spectrogram stft(std::span<const float> samples, size_t frameSize, size_t hop, Window window = Window::Hann);
+
+} // namespace fourier
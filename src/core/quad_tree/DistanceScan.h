@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <span>
+
+#include "Metric.h"
+#include "util/CpuFeatures.h"
+
+/*
+ * SSE2 is part of every x86-64 CPU, so it needs neither compiler flags nor a check at runtime.
+ * AVX2 is compiled into its own translation unit (DistanceScanAvx2.cpp) and is picked at runtime,
+ * like the FFT kernels (see FftKernel.h).
+ */
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define QUAD_TREE_SCAN_SSE2 1
+#endif
+
+/*
+ * 4 floats that are processed at once.
+ * It only offers the operations the metrics in Metric.h need.
+ */
+#if defined(QUAD_TREE_SCAN_SSE2)
+struct FloatLanes {
+    static constexpr unsigned int COUNT = 4;
+    __m128 v;
+
+    static FloatLanes load(const float *p) { return {_mm_loadu_ps(p)}; }
+    static FloatLanes broadcast(float f) { return {_mm_set1_ps(f)}; }
+    void store(float *p) const { _mm_storeu_ps(p, v); }
+    int lessThan(float f) const { return _mm_movemask_ps(_mm_cmplt_ps(v, _mm_set1_ps(f))); }
+};
+
+inline FloatLanes operator+(const FloatLanes &l, const FloatLanes &r) { return {_mm_add_ps(l.v, r.v)}; }
+inline FloatLanes operator-(const FloatLanes &l, const FloatLanes &r) { return {_mm_sub_ps(l.v, r.v)}; }
+inline FloatLanes operator*(const FloatLanes &l, const FloatLanes &r) { return {_mm_mul_ps(l.v, r.v)}; }
+inline FloatLanes abs(const FloatLanes &l) { return {_mm_andnot_ps(_mm_set1_ps(-0.0F), l.v)}; }
+inline FloatLanes max(const FloatLanes &l, const FloatLanes &r) { return {_mm_max_ps(l.v, r.v)}; }
+#endif
+
+/*
+ * Computes the reduced distances (see Metric.h) from query to the count points starting at first into distances
+ * and returns a mask of the ones that are closer than bound.
+ * count is a multiple of AVX2_LANE_COUNT and at most AVX2_BLOCK_SIZE.
+ */
+using DistanceBlockFunction = uint64_t (*)(const float *const *axisCoords, const float *query, unsigned int first,
+                                           unsigned int count, float bound, float *distances);
+
+constexpr unsigned int AVX2_LANE_COUNT = 8;
+constexpr unsigned int AVX2_BLOCK_SIZE = 64;
+
+/*
+ * The AVX2 scan of Metric in D dimensions, nullptr if the build does not support it.
+ * Only the metrics of Metric.h in 2D and 3D have one.
+ */
+template <typename Metric, glm::length_t D> DistanceBlockFunction avx2DistanceBlock() { return nullptr; }
+template <> DistanceBlockFunction avx2DistanceBlock<EuclideanMetric, 2>();
+template <> DistanceBlockFunction avx2DistanceBlock<EuclideanMetric, 3>();
+template <> DistanceBlockFunction avx2DistanceBlock<ManhattanMetric, 2>();
+template <> DistanceBlockFunction avx2DistanceBlock<ManhattanMetric, 3>();
+template <> DistanceBlockFunction avx2DistanceBlock<ChebyshevMetric, 2>();
+template <> DistanceBlockFunction avx2DistanceBlock<ChebyshevMetric, 3>();
+
+// the AVX2 scan, if the CPU the program is running on supports it, chosen on the first call
+template <typename Metric, glm::length_t D> DistanceBlockFunction bestAvx2DistanceBlock() {
+    static const DistanceBlockFunction block = cpuSupportsAvx2() ? avx2DistanceBlock<Metric, D>() : nullptr;
+    return block;
+}
+
+/*
+ * Computes the reduced distances (see Metric.h) from query to the points [first, last),
+ * which are stored as one array per axis.
+ * accept(index, distance) is called for every point that is closer than bound and has to return the new bound.
+ * MAX_LANE_COUNT limits the SIMD width that is used, so that the tests can compare all of them with the scalar loop.
+ */
+template <typename Metric, glm::length_t D, unsigned int MAX_LANE_COUNT = AVX2_LANE_COUNT, typename Accept>
+inline float scanDistances(const std::array<std::span<const float>, D> &coords, unsigned int first,
+                           const unsigned int last, const glm::vec<D, float> &query, float bound, Accept &&accept) {
+    // local copies, accept could otherwise force the compiler to reload them after every call
+    std::array<const float *, D> axisCoords = {};
+    for (glm::length_t axis = 0; axis < D; axis++) {
+        axisCoords[axis] = coords[axis].data();
+    }
+
+    if constexpr (MAX_LANE_COUNT >= AVX2_LANE_COUNT) {
+        const DistanceBlockFunction block = bestAvx2DistanceBlock<Metric, D>();
+        if (block != nullptr && first + AVX2_LANE_COUNT <= last) {
+            std::array<float, D> queryCoords = {};
+            for (glm::length_t axis = 0; axis < D; axis++) {
+                queryCoords[axis] = query[axis];
+            }
+
+            float distances[AVX2_BLOCK_SIZE];
+            while (first + AVX2_LANE_COUNT <= last) {
+                const unsigned int count =
+                      std::min((last - first) / AVX2_LANE_COUNT * AVX2_LANE_COUNT, AVX2_BLOCK_SIZE);
+                uint64_t mask = block(axisCoords.data(), queryCoords.data(), first, count, bound, distances);
+                while (mask != 0) {
+                    const int lane = std::countr_zero(mask);
+                    mask &= mask - 1;
+                    // the bound might have shrunk since the comparison
+                    if (distances[lane] < bound) {
+                        bound = accept(first + lane, distances[lane]);
+                    }
+                }
+                first += count;
+            }
+        }
+    }
+
+#if defined(QUAD_TREE_SCAN_SSE2)
+    if constexpr (MAX_LANE_COUNT >= FloatLanes::COUNT) {
+        std::array<FloatLanes, D> queryLanes = {};
+        for (glm::length_t axis = 0; axis < D; axis++) {
+            queryLanes[axis] = FloatLanes::broadcast(query[axis]);
+        }
+
+        float distances[FloatLanes::COUNT];
+        for (; first + FloatLanes::COUNT <= last; first += FloatLanes::COUNT) {
+            auto distance = Metric::term(FloatLanes::load(axisCoords[0] + first) - queryLanes[0]);
+            for (glm::length_t axis = 1; axis < D; axis++) {
+                const auto delta = FloatLanes::load(axisCoords[axis] + first) - queryLanes[axis];
+                distance = Metric::combine(distance, Metric::term(delta));
+            }
+
+            const int mask = distance.lessThan(bound);
+            if (mask == 0) {
+                continue;
+            }
+
+            distance.store(distances);
+            for (unsigned int lane = 0; lane < FloatLanes::COUNT; lane++) {
+                // the bound might have shrunk since the comparison
+                if ((mask & (1 << lane)) != 0 && distances[lane] < bound) {
+                    bound = accept(first + lane, distances[lane]);
+                }
+            }
+        }
+    }
+#endif
+
+    for (; first < last; first++) {
+        float distance = Metric::term(axisCoords[0][first] - query[0]);
+        for (glm::length_t axis = 1; axis < D; axis++) {
+            distance = Metric::combine(distance, Metric::term(axisCoords[axis][first] - query[axis]));
+        }
+        if (distance < bound) {
+            bound = accept(first, distance);
+        }
+    }
+
+    return bound;
+}
@@ -0,0 +1,73 @@
+#include "DistanceScan.h"
+
+// this file is compiled with AVX2 enabled on x86 (see CMakeLists.txt)
+#if defined(__AVX2__)
+#define QUAD_TREE_SCAN_AVX2 1
+#endif
+
+#ifdef QUAD_TREE_SCAN_AVX2
+
+#include <immintrin.h>
+
+namespace {
+
+/*
+ * 8 floats that are processed at once, like FloatLanes in DistanceScan.h.
+ * Everything in here has to stay local to this file, the linker could otherwise pick the AVX2 version of an inline
+ * function for the code that runs on every CPU.
+ */
+struct Avx2Lanes {
+    __m256 v;
+
+    static Avx2Lanes load(const float *p) { return {_mm256_loadu_ps(p)}; }
+    static Avx2Lanes broadcast(float f) { return {_mm256_set1_ps(f)}; }
+    void store(float *p) const { _mm256_storeu_ps(p, v); }
+    int lessThan(float f) const { return _mm256_movemask_ps(_mm256_cmp_ps(v, _mm256_set1_ps(f), _CMP_LT_OQ)); }
+
+    friend Avx2Lanes operator+(const Avx2Lanes &l, const Avx2Lanes &r) { return {_mm256_add_ps(l.v, r.v)}; }
+    friend Avx2Lanes operator-(const Avx2Lanes &l, const Avx2Lanes &r) { return {_mm256_sub_ps(l.v, r.v)}; }
+    friend Avx2Lanes operator*(const Avx2Lanes &l, const Avx2Lanes &r) { return {_mm256_mul_ps(l.v, r.v)}; }
+    friend Avx2Lanes abs(const Avx2Lanes &l) { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0F), l.v)}; }
+    friend Avx2Lanes max(const Avx2Lanes &l, const Avx2Lanes &r) { return {_mm256_max_ps(l.v, r.v)}; }
+};
+
+template <typename Metric, glm::length_t D>
+uint64_t distanceBlock(const float *const *axisCoords, const float *query, unsigned int first, unsigned int count,
+                       float bound, float *distances) {
+    Avx2Lanes queryLanes[D];
+    for (glm::length_t axis = 0; axis < D; axis++) {
+        queryLanes[axis] = Avx2Lanes::broadcast(query[axis]);
+    }
+
+    uint64_t mask = 0;
+    for (unsigned int offset = 0; offset < count; offset += AVX2_LANE_COUNT) {
+        auto distance = Metric::term(Avx2Lanes::load(axisCoords[0] + first + offset) - queryLanes[0]);
+        for (glm::length_t axis = 1; axis < D; axis++) {
+            const auto delta = Avx2Lanes::load(axisCoords[axis] + first + offset) - queryLanes[axis];
+            distance = Metric::combine(distance, Metric::term(delta));
+        }
+        distance.store(distances + offset);
+        mask |= static_cast<uint64_t>(distance.lessThan(bound)) << offset;
+    }
+    return mask;
+}
+
+} // namespace
+
+template <> DistanceBlockFunction avx2DistanceBlock<EuclideanMetric, 2>() { return &distanceBlock<EuclideanMetric, 2>; }
+template <> DistanceBlockFunction avx2DistanceBlock<EuclideanMetric, 3>() { return &distanceBlock<EuclideanMetric, 3>; }
+template <> DistanceBlockFunction avx2DistanceBlock<ManhattanMetric, 2>() { return &distanceBlock<ManhattanMetric, 2>; }
+template <> DistanceBlockFunction avx2DistanceBlock<ManhattanMetric, 3>() { return &distanceBlock<ManhattanMetric, 3>; }
+template <> DistanceBlockFunction avx2DistanceBlock<ChebyshevMetric, 2>() { return &distanceBlock<ChebyshevMetric, 2>; }
+template <> DistanceBlockFunction avx2DistanceBlock<ChebyshevMetric, 3>() { return &distanceBlock<ChebyshevMetric, 3>; }
+
+#else
+
+template <> DistanceBlockFunction avx2DistanceBlock<EuclideanMetric, 2>() { return nullptr; }
+template <> DistanceBlockFunction avx2DistanceBlock<EuclideanMetric, 3>() { return nullptr; }
+template <> DistanceBlockFunction avx2DistanceBlock<ManhattanMetric, 2>() { return nullptr; }
+template <> DistanceBlockFunction avx2DistanceBlock<ManhattanMetric, 3>() { return nullptr; }
+template <> DistanceBlockFunction avx2DistanceBlock<ChebyshevMetric, 2>() { return nullptr; }
+template <> DistanceBlockFunction avx2DistanceBlock<ChebyshevMetric, 3>() { return nullptr; }
+
+#endif
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <glm/glm.hpp>
+#include <type_traits>
+
+#include "util/BoundingBox.h"
+
+/*
+ * A metric turns the per-axis differences of two points into a "reduced" distance:
+ * combine(term(dx), combine(term(dy), ...)).
+ * Reduced distances only have to grow with the real distance, so they can be compared, but not added up.
+ * term(radius) converts a real distance into a reduced one.
+ * term and combine are templates, so that the same code runs on floats and on SIMD lanes (see DistanceScan.h).
+ */
+struct EuclideanMetric {
+    // the squared distance, which saves the square root
+    template <typename V> static V term(const V &delta) { return delta * delta; }
+    template <typename V> static V combine(const V &d1, const V &d2) { return d1 + d2; }
+};
+
+struct ManhattanMetric {
+    template <typename V> static V term(const V &delta) {
+        using std::abs;
+        return abs(delta);
+    }
+    template <typename V> static V combine(const V &d1, const V &d2) { return d1 + d2; }
+};
+
+// L-infinity
+struct ChebyshevMetric {
+    template <typename V> static V term(const V &delta) {
+        using std::abs;
+        return abs(delta);
+    }
+    template <typename V> static V combine(const V &d1, const V &d2) {
+        using std::max;
+        return max(d1, d2);
+    }
+};
+
+template <typename Metric, glm::length_t D> inline float reducedLength(const glm::vec<D, float> &delta) {
+    float result = Metric::term(delta[0]);
+    for (glm::length_t axis = 1; axis < D; axis++) {
+        result = Metric::combine(result, Metric::term(delta[axis]));
+    }
+    return result;
+}
+
+template <typename Metric, glm::length_t D>
+inline float reducedDistance(const glm::vec<D, float> &p1, const glm::vec<D, float> &p2) {
+    return reducedLength<Metric, D>(p1 - p2);
+}
+
+// the closest point of a box is the same for all of the metrics above, because they grow with every axis separately
+template <typename Metric, glm::length_t D>
+inline float reducedDistance(const BoundingBox<D> &bb, const glm::vec<D, float> &point) {
+    return reducedDistance<Metric, D>(bb.closestPointOnSurface(point), point);
+}
+
+/*
+ * The axes a tree splits along, one level after the other, starting again at the front once all of them were used.
+ */
+template <glm::length_t... AXES> struct SplitAxes {
+    static_assert(sizeof...(AXES) > 0, "A tree has to split along at least one axis");
+    static constexpr std::array<glm::length_t, sizeof...(AXES)> VALUES = {AXES...};
+};
+
+// terrain lies in the x/z plane in 3D and in the x/y plane in 2D
+template <glm::length_t D> using DefaultSplitAxes = std::conditional_t<D == 2, SplitAxes<1, 0>, SplitAxes<2, 0>>;
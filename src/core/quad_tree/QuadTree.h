@@ -1,137 +1,473 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
 #include <functional>
 #include <glm/glm.hpp>
+#include <iostream>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <type_traits>
 #include <vector>
 
+#include "DistanceScan.h"
+#include "Metric.h"
 #include "util/BoundingBox.h"
+#include "util/Frustum.h"
+#include "util/MappedFile.h"
 
 /*
  * Running the benchmark revealed that K=256 is a pretty optimal size for the tree.
  */
 constexpr unsigned int DEFAULT_MAX_ELEMENTS_PER_NODE = 256;
 
+/*
+ * Subtrees with fewer elements than this are built on the current thread.
+ * Spawning tasks for them costs more than it saves.
+ */
+constexpr unsigned int PARALLEL_BUILD_CUTOFF = 16384;
+
 inline float distanceSq(const glm::vec3 &p1, const glm::vec3 &p2) {
-    auto vec = p1 - p2;
-    return vec.x * vec.x + vec.y * vec.y + vec.z * vec.z;
+    return reducedDistance<EuclideanMetric, 3>(p1, p2);
 }
 
-template <typename T> struct QuadTree {
-    using Element = typename std::pair<glm::vec3, T>;
-    using Iterator = typename std::vector<Element>::iterator;
+inline float distanceSq(const BoundingBox3 &bb, const glm::vec3 &point) {
+    return reducedDistance<EuclideanMetric, 3>(bb, point);
+}
+
+/*
+ * Trades accuracy for speed in kNN queries, the defaults give exact results.
+ * A node is skipped once its distance times (1 + epsilon) is not smaller than the current k-th best distance,
+ * so every result is at most (1 + epsilon) times further away than the true neighbour of the same rank.
+ * maxLeaves stops the search after that many leaves, the results are then the best ones found so far.
+ */
+struct QuadTreeSearchParams {
+    float epsilon = 0.0F;
+    unsigned int maxLeaves = std::numeric_limits<unsigned int>::max();
+};
+
+/*
+ * Layout of a saved QuadTree:
+ *   - QuadTreeFileHeader
+ *   - one QuadTreeFileTree for each tree
+ *   - the node, coordinate and value arrays of each tree, every one of them aligned to QUAD_TREE_FILE_ALIGNMENT
+ * All offsets are relative to the start of the file, so a mapped file can be queried in place.
+ */
+constexpr uint64_t QUAD_TREE_FILE_ALIGNMENT = 64;
+constexpr uint32_t QUAD_TREE_FILE_VERSION = 2;
+
+struct QuadTreeFileHeader {
+    char magic[8] = {'Q', 'U', 'A', 'D', 'T', 'R', 'E', 'E'};
+    uint32_t version = QUAD_TREE_FILE_VERSION;
+    uint32_t dimension = 0;
+    uint32_t nodeSize = 0;
+    uint32_t valueSize = 0;
+    uint32_t maxElementsPerNode = 0;
+    uint32_t reserved = 0;
+    uint64_t treeCount = 0;
+};
+
+struct QuadTreeFileTree {
+    uint64_t nodeCount = 0;
+    uint64_t elementCount = 0;
+    uint64_t nodesOffset = 0;
+    // only the first dimension entries are used
+    std::array<uint64_t, 3> coordOffsets = {};
+    uint64_t valuesOffset = 0;
+};
+
+/*
+ * The elements are spread over a small forest of static trees (the "logarithmic method").
+ * Inserting builds a new tree from the new elements and every existing tree that is less than twice as big.
+ * This keeps the tree sizes decreasing geometrically, so there are only O(log n) trees
+ * and each element is rebuilt O(log n) times, instead of rebuilding everything on every insert.
+ *
+ * D is the dimension of the points (2 or 3), Metric is used to measure distances (see Metric.h)
+ * and Axes are the axes the trees are split along (see SplitAxes).
+ * All of them are resolved at compile time.
+ */
+template <typename T, glm::length_t D = 3, typename Metric = EuclideanMetric, typename Axes = DefaultSplitAxes<D>>
+struct QuadTree {
+    static_assert(D == 2 || D == 3, "Only 2D and 3D trees are supported");
+
+    static constexpr glm::length_t DIMENSION = D;
+    using MetricType = Metric;
+    using Vec = glm::vec<D, float>;
+    using Box = BoundingBox<D>;
+    using Element = typename std::pair<Vec, T>;
+
+    // the distance is a reduced one, see Metric.h
+    using Candidate = std::pair<float, T>;
+    using Intersection = Frustum::Intersection;
 
     struct Node {
-        Iterator begin;
-        Iterator end;
-        BoundingBox3 bb = {};
-        bool parity = false;
-        std::shared_ptr<Node> left = nullptr;
-        std::shared_ptr<Node> right = nullptr;
-
-        Node(unsigned int maxElementsPerNode, Iterator begin, Iterator end) : begin(begin), end(end) {
-            init(maxElementsPerNode);
-        }
-        Node(unsigned int maxElementsPerNode, Iterator begin, Iterator end, bool parity)
-            : begin(begin), end(end), parity(parity) {
-            init(maxElementsPerNode);
-        }
-        ~Node() = default;
-
-        void init(unsigned int _maxElementsPerNode) {
-            std::function<bool(const Element &, const Element &)> comp;
-            if (parity) {
-                comp = [](const Element &l, const Element &r) { return l.first.x < r.first.x; };
-            } else {
-                comp = [](const Element &l, const Element &r) { return l.first.z < r.first.z; };
-            }
-            std::sort(begin, end, comp);
-
-            const auto numElements = end - begin;
-            if (numElements <= _maxElementsPerNode) {
-                for (Iterator itr = begin; itr != end; itr++) {
-                    bb.update(itr->first);
+        Box bb = {};
+        unsigned int begin = 0;
+        unsigned int end = 0;
+    };
+
+    struct BatchResult {
+        std::vector<size_t> offsets = {};
+        std::vector<T> values = {};
+    };
+
+    static bool isCloser(const Candidate &c1, const Candidate &c2) { return c1.first < c2.first; }
+
+    /*
+     * Replaces the furthest candidate of a max-heap with a closer one.
+     * A single sift-down costs about half of what pop_heap and push_heap together do,
+     * which matters because a kNN search replaces candidates dozens of times per leaf.
+     */
+    static void replaceFurthest(std::vector<Candidate> &heap, const Candidate &candidate) {
+        const size_t size = heap.size();
+        size_t hole = 0;
+        while (true) {
+            size_t child = 2 * hole + 1;
+            if (child >= size) {
+                break;
+            }
+            if (child + 1 < size && isCloser(heap[child], heap[child + 1])) {
+                child++;
+            }
+            if (!isCloser(candidate, heap[child])) {
+                break;
+            }
+            heap[hole] = heap[child];
+            hole = child;
+        }
+        heap[hole] = candidate;
+    }
+
+    /*
+     * The nodes of a tree are stored in a single flat array in breadth-first order.
+     * The children of node i live at 2i+1 and 2i+2, so there are no pointers to follow.
+     * Every leaf sits on the same level and holds at most maxElementsPerNode elements.
+     * The elements are stored as one array per axis, so that leaves can be scanned with SIMD instructions.
+     * The arrays are views into memory that is either owned by the tree or mapped from a file (see openMapped).
+     */
+    struct Tree {
+        static constexpr unsigned int ROOT = 0;
+
+        std::span<const Node> nodes = {};
+        std::array<std::span<const float>, D> coords = {};
+        std::span<const T> values = {};
+
+        Tree(std::vector<Element> &&elements, unsigned int maxElementsPerNode) {
+            const auto maxElements = std::max(maxElementsPerNode, 1U);
+            unsigned int depth = 0;
+            while ((elements.size() + (1ULL << depth) - 1) >> depth > maxElements) {
+                depth++;
+            }
+
+            auto owned = std::make_shared<OwnedStorage>();
+            owned->nodes.assign((2ULL << depth) - 1, Node());
+
+#pragma omp parallel if (elements.size() > PARALLEL_BUILD_CUTOFF)
+#pragma omp single
+            build(owned->nodes, elements, ROOT, 0, elements.size());
+
+            for (glm::length_t axis = 0; axis < D; axis++) {
+                owned->coords[axis].reserve(elements.size());
+                for (const auto &element : elements) {
+                    owned->coords[axis].push_back(element.first[axis]);
                 }
-                return;
+                coords[axis] = owned->coords[axis];
+            }
+            owned->values.reserve(elements.size());
+            for (const auto &element : elements) {
+                owned->values.push_back(element.second);
             }
 
-            const auto numElementsHalf = numElements / 2;
-            left = std::make_shared<Node>(_maxElementsPerNode, begin, begin + numElementsHalf, !parity);
-            bb.update(left->bb);
+            nodes = owned->nodes;
+            values = owned->values;
+            storage = std::move(owned);
+        }
 
-            right = std::make_shared<Node>(_maxElementsPerNode, begin + numElementsHalf, end, !parity);
-            bb.update(right->bb);
+        Tree(std::shared_ptr<const void> memory, std::span<const Node> treeNodes,
+             const std::array<std::span<const float>, D> &treeCoords, std::span<const T> treeValues)
+            : nodes(treeNodes), coords(treeCoords), values(treeValues), storage(std::move(memory)) {}
+
+        static unsigned int left(unsigned int node) { return 2 * node + 1; }
+        static unsigned int right(unsigned int node) { return 2 * node + 2; }
+        static unsigned int depth(unsigned int node) { return std::bit_width(node + 1) - 1; }
+        static glm::length_t axis(unsigned int node) { return Axes::VALUES[depth(node) % Axes::VALUES.size()]; }
+        bool isLeaf(unsigned int node) const { return left(node) >= nodes.size(); }
+
+        Vec point(unsigned int index) const {
+            Vec result = {};
+            for (glm::length_t axis = 0; axis < D; axis++) {
+                result[axis] = coords[axis][index];
+            }
+            return result;
         }
+        const T &value(unsigned int index) const { return values[index]; }
+        Element element(unsigned int index) const { return std::make_pair(point(index), values[index]); }
+        size_t size() const { return values.size(); }
+
+        void search(const Vec &query, const unsigned int k, const QuadTreeSearchParams &params,
+                    std::vector<Candidate> &closestElements, std::vector<unsigned int> &nodeStack,
+                    unsigned int &visitedLeaves) const {
+            // reduced distances scale with term(s) when the real distances scale with s
+            const float pruneFactor = Metric::term(1.0F + params.epsilon);
+            // closestElements is a max-heap of at most k candidates, its top is the current pruning bound
+            float bound = std::numeric_limits<float>::infinity();
+            if (closestElements.size() >= k) {
+                bound = closestElements.front().first;
+            }
 
-        inline bool isLeaf() { return left == nullptr; }
-    };
+            const auto accept = [this, k, &closestElements](unsigned int index, float distance) {
+                if (closestElements.size() >= k) {
+                    replaceFurthest(closestElements, std::make_pair(distance, values[index]));
+                } else {
+                    closestElements.emplace_back(distance, values[index]);
+                    std::push_heap(closestElements.begin(), closestElements.end(), isCloser);
+                }
 
-    QuadTree()
-        : maxElementsPerNode(DEFAULT_MAX_ELEMENTS_PER_NODE), elements({}),
-          root(std::make_shared<Node>(maxElementsPerNode, elements.begin(), elements.end())) {}
-    explicit QuadTree(unsigned int maxElementsPerNode)
-        : maxElementsPerNode(maxElementsPerNode), elements({}),
-          root(std::make_shared<Node>(maxElementsPerNode, elements.begin(), elements.end())) {}
-    ~QuadTree() = default;
-    void insert(const glm::vec3 &point, T data) {
-        elements.push_back(std::make_pair(point, data));
-        root = std::make_shared<Node>(maxElementsPerNode, elements.begin(), elements.end());
-    }
+                if (closestElements.size() >= k) {
+                    return closestElements.front().first;
+                }
+                return std::numeric_limits<float>::infinity();
+            };
+
+            nodeStack.push_back(ROOT);
+            while (!nodeStack.empty()) {
+                const unsigned int currentNode = nodeStack.back();
+                nodeStack.pop_back();
+
+                const auto distToBB = reducedDistance<Metric, D>(nodes[currentNode].bb, query);
+                if (distToBB * pruneFactor >= bound) {
+                    continue;
+                }
+
+                if (!isLeaf(currentNode)) {
+                    // children that are already too far away are not pushed at all,
+                    // the check after popping only catches the ones the bound has shrunk past since
+                    const float distLeft = reducedDistance<Metric, D>(nodes[left(currentNode)].bb, query);
+                    const float distRight = reducedDistance<Metric, D>(nodes[right(currentNode)].bb, query);
+                    const bool visitLeft = distLeft * pruneFactor < bound;
+                    const bool visitRight = distRight * pruneFactor < bound;
+                    if (distLeft < distRight) {
+                        if (visitRight) {
+                            nodeStack.push_back(right(currentNode));
+                        }
+                        if (visitLeft) {
+                            nodeStack.push_back(left(currentNode));
+                        }
+                    } else {
+                        if (visitLeft) {
+                            nodeStack.push_back(left(currentNode));
+                        }
+                        if (visitRight) {
+                            nodeStack.push_back(right(currentNode));
+                        }
+                    }
+                    continue;
+                }
+
+                if (visitedLeaves >= params.maxLeaves) {
+                    nodeStack.clear();
+                    return;
+                }
+                visitedLeaves++;
 
-    void insert(const std::vector<Element> &newElements) {
-        elements.reserve(elements.size() + newElements.size());
-        for (const auto &element : newElements) {
-            elements.push_back(element);
+                bound = scanDistances<Metric, D>(coords, nodes[currentNode].begin, nodes[currentNode].end, query,
+                                                 bound, accept);
+            }
         }
-        root = std::make_shared<Node>(maxElementsPerNode, elements.begin(), elements.end());
-    }
 
-    bool get(const glm::vec3 &query, const unsigned int k, std::vector<T> &result) const {
-        if (elements.empty()) {
-            return false;
+        /*
+         * Calls visit(point, value) for every element inside of a range.
+         * classify(bb) tells whether a node is outside, inside or intersecting the range.
+         * contains(point) is only evaluated for the elements of leaves that intersect the range.
+         */
+        template <typename Classify, typename Contains, typename Visitor>
+        void visitRange(const Classify &classify, const Contains &contains, Visitor &visit) const {
+            // all leaves are on the same level, so the stack never holds more than depth + 1 entries
+            std::array<std::pair<unsigned int, bool>, 64> stack = {};
+            size_t stackSize = 0;
+            stack[stackSize++] = {ROOT, false};
+            while (stackSize > 0) {
+                auto [current, inside] = stack[--stackSize];
+
+                if (!inside) {
+                    const auto intersection = classify(nodes[current].bb);
+                    if (intersection == Intersection::OUTSIDE) {
+                        continue;
+                    }
+                    inside = intersection == Intersection::INSIDE;
+                }
+
+                if (!isLeaf(current)) {
+                    stack[stackSize++] = {right(current), inside};
+                    stack[stackSize++] = {left(current), inside};
+                    continue;
+                }
+
+                for (unsigned int i = nodes[current].begin; i < nodes[current].end; i++) {
+                    const auto p = point(i);
+                    if (inside || contains(p)) {
+                        visit(p, values[i]);
+                    }
+                }
+            }
+        }
+
+        void traversePreOrder(const std::function<void(unsigned int)> &traversalFunc) const {
+            std::vector<unsigned int> stack = {ROOT};
+            while (!stack.empty()) {
+                const unsigned int current = stack.back();
+                stack.pop_back();
+
+                traversalFunc(current);
+
+                if (!isLeaf(current)) {
+                    stack.push_back(right(current));
+                    stack.push_back(left(current));
+                }
+            }
         }
 
-        std::vector<std::pair<float, T>> closestElements = {};
-        std::vector<std::shared_ptr<Node>> nodeQueue = {root};
-        while (!nodeQueue.empty()) {
-            std::shared_ptr<Node> currentNode = nodeQueue.back();
-            nodeQueue.pop_back();
+        void traversePostOrder(const std::function<void(unsigned int)> &traversalFunc) const {
+            // the second member marks nodes whose children have already been pushed
+            std::vector<std::pair<unsigned int, bool>> stack = {{ROOT, false}};
+            while (!stack.empty()) {
+                auto [current, expanded] = stack.back();
+                stack.pop_back();
+
+                if (expanded || isLeaf(current)) {
+                    traversalFunc(current);
+                    continue;
+                }
 
-            const auto closestPoint = currentNode->bb.closestPointOnSurface(query);
-            const auto distToBBSq = distanceSq(closestPoint, query);
-            if (!closestElements.empty() && distToBBSq >= closestElements.back().first) {
-                continue;
+                stack.emplace_back(current, true);
+                stack.emplace_back(right(current), false);
+                stack.emplace_back(left(current), false);
             }
+        }
+
+        void traverseInOrder(const std::function<void(unsigned int)> &traversalFunc) const {
+            std::vector<unsigned int> stack = {};
+            unsigned int current = ROOT;
+            while (true) {
+                if (current < nodes.size()) {
+                    stack.push_back(current);
+                    current = left(current);
+                } else if (!stack.empty()) {
+                    current = stack.back();
+                    stack.pop_back();
+
+                    traversalFunc(current);
 
-            if (!currentNode->isLeaf()) {
-                glm::vec3 closestPointLeft = currentNode->left->bb.closestPointOnSurface(query);
-                glm::vec3 closestPointRight = currentNode->right->bb.closestPointOnSurface(query);
-                const float distLeftSq = distanceSq(closestPointLeft, query);
-                const float distRightSq = distanceSq(closestPointRight, query);
-                if (distLeftSq < distRightSq) {
-                    nodeQueue.push_back(currentNode->right);
-                    nodeQueue.push_back(currentNode->left);
+                    current = right(current);
                 } else {
-                    nodeQueue.push_back(currentNode->left);
-                    nodeQueue.push_back(currentNode->right);
+                    break;
                 }
-                continue;
-            }
-
-            for (Iterator itr = currentNode->begin; itr != currentNode->end; itr++) {
-                const float distSq = distanceSq(itr->first, query);
-                if (closestElements.empty() || closestElements.size() < k || distSq < closestElements.back().first) {
-                    closestElements.push_back(std::make_pair(distSq, itr->second));
-                    std::sort(closestElements.begin(), closestElements.end(),
-                              [](const std::pair<float, T> &e1, const std::pair<float, T> &e2) {
-                                  return e1.first < e2.first;
-                              });
-                    while (closestElements.size() > k) {
-                        closestElements.pop_back();
-                    }
+            }
+        }
+
+      private:
+        struct OwnedStorage {
+            std::vector<Node> nodes = {};
+            std::array<std::vector<float>, D> coords = {};
+            std::vector<T> values = {};
+        };
+
+        // keeps the memory behind the views alive, it is shared between copies of the tree, because it never changes
+        std::shared_ptr<const void> storage = nullptr;
+
+        static void build(std::vector<Node> &nodes, std::vector<Element> &elements, unsigned int node,
+                          unsigned int first, unsigned int last) {
+            nodes[node].begin = first;
+            nodes[node].end = last;
+
+            const auto splitAxis = axis(node);
+            const auto less = [splitAxis](const Element &l, const Element &r) {
+                return l.first[splitAxis] < r.first[splitAxis];
+            };
+
+            if (left(node) >= nodes.size()) {
+                // leaves are small, sorting them keeps their order deterministic without changing the complexity
+                std::sort(elements.begin() + first, elements.begin() + last, less);
+                for (unsigned int i = first; i < last; i++) {
+                    nodes[node].bb.update(elements[i].first);
                 }
+                return;
             }
+
+            // partitioning around the median is enough to split the elements, no need to sort them
+            const auto middle = first + (last - first) / 2;
+            std::nth_element(elements.begin() + first, elements.begin() + middle, elements.begin() + last, less);
+
+#pragma omp task default(shared) if (last - first > PARALLEL_BUILD_CUTOFF)
+            build(nodes, elements, left(node), first, middle);
+            build(nodes, elements, right(node), middle, last);
+#pragma omp taskwait
+
+            nodes[node].bb.update(nodes[left(node)].bb);
+            nodes[node].bb.update(nodes[right(node)].bb);
         }
+    };
+
+    using TraversalFunc = std::function<void(const Tree &, unsigned int)>;
+
+    QuadTree() = default;
+    explicit QuadTree(unsigned int maxElementsPerNode) : maxElementsPerNode(maxElementsPerNode) {}
+    ~QuadTree() = default;
+
+    void insert(const Vec &point, T data) {
+        const Element element = std::make_pair(point, data);
+        insert(&element, &element + 1);
+    }
+
+    void insert(const std::vector<Element> &newElements) { insert(newElements.begin(), newElements.end()); }
+
+    template <typename InputIterator> void insert(InputIterator first, InputIterator last) {
+        auto merged = std::vector<Element>(first, last);
+        if (merged.empty()) {
+            return;
+        }
+
+        // trees are ordered by decreasing size, so the ones to merge with are at the back
+        while (!trees.empty() && trees.back().size() < 2 * merged.size()) {
+            const auto &absorbed = trees.back();
+            merged.reserve(merged.size() + absorbed.size());
+            for (unsigned int i = 0; i < absorbed.size(); i++) {
+                merged.push_back(absorbed.element(i));
+            }
+            trees.pop_back();
+        }
+
+        trees.emplace_back(std::move(merged), maxElementsPerNode);
+    }
+
+    size_t size() const {
+        size_t result = 0;
+        for (const auto &tree : trees) {
+            result += tree.size();
+        }
+        return result;
+    }
+
+    bool get(const Vec &query, const unsigned int k, std::vector<T> &result,
+             const QuadTreeSearchParams &params = {}) const {
+        if (trees.empty()) {
+            return false;
+        }
+        if (k == 0) {
+            return true;
+        }
+
+        std::vector<Candidate> closestElements = {};
+        closestElements.reserve(std::min(static_cast<size_t>(k), size()));
+        std::vector<unsigned int> nodeStack = {};
+        search(query, k, params, closestElements, nodeStack);
 
         for (const auto &elem : closestElements) {
             result.push_back(elem.second);
@@ -140,7 +476,63 @@ template <typename T> struct QuadTree {
         return true;
     }
 
-    bool get(const glm::vec3 &query, T &closestElement) const {
+    /*
+     * Answers many kNN queries at once, spread over all available threads.
+     * Each thread reuses its candidate heap and traversal stack for all of its queries.
+     * The results are stored back to back in result.values, ordered by query.
+     * The results for query i are located in [result.offsets[i], result.offsets[i + 1]).
+     */
+    bool getBatch(const std::vector<Vec> &queries, const unsigned int k, BatchResult &result,
+                  const QuadTreeSearchParams &params = {}) const {
+        result.offsets.assign(queries.size() + 1, 0);
+        result.values.clear();
+        if (trees.empty()) {
+            return false;
+        }
+
+        const auto stride = std::min(static_cast<size_t>(k), size());
+        if (stride == 0) {
+            return true;
+        }
+        result.values.resize(queries.size() * stride);
+
+        // every query writes into its own slot of the output first and records how many results it found there
+        std::vector<size_t> counts = std::vector<size_t>(queries.size());
+#pragma omp parallel
+        {
+            std::vector<Candidate> closestElements = {};
+            closestElements.reserve(stride);
+            std::vector<unsigned int> nodeStack = {};
+
+#pragma omp for schedule(dynamic, 64)
+            for (int64_t i = 0; i < static_cast<int64_t>(queries.size()); i++) {
+                closestElements.clear();
+                search(queries[i], k, params, closestElements, nodeStack);
+
+                auto *output = result.values.data() + i * stride;
+                for (size_t j = 0; j < closestElements.size(); j++) {
+                    output[j] = closestElements[j].second;
+                }
+                counts[i] = closestElements.size();
+            }
+        }
+
+        // close the gaps left by queries that found fewer than stride results
+        size_t offset = 0;
+        for (size_t i = 0; i < queries.size(); i++) {
+            result.offsets[i] = offset;
+            if (offset != i * stride) {
+                std::copy_n(result.values.begin() + i * stride, counts[i], result.values.begin() + offset);
+            }
+            offset += counts[i];
+        }
+        result.offsets[queries.size()] = offset;
+        result.values.resize(offset);
+
+        return true;
+    }
+
+    bool get(const Vec &query, T &closestElement) const {
         std::vector<T> result = {};
         bool success = get(query, 1, result);
         if (!success || result.empty()) {
@@ -150,77 +542,238 @@ template <typename T> struct QuadTree {
         return true;
     }
 
-    void traversePreOrder(const std::function<void(std::shared_ptr<Node>)> &traversalFunc) const {
-        std::vector<std::shared_ptr<Node>> stack = {root};
-        while (!stack.empty()) {
-            auto current = stack.back();
-            stack.pop_back();
-            if (current == nullptr) {
-                continue;
+    /*
+     * The range queries call visit(const Vec &point, const T &value) for every element inside of the range.
+     * They do not allocate, so they can be used every frame.
+     * The radius is measured with the metric of the tree, so it describes a diamond for the Manhattan metric
+     * and a box for the Chebyshev metric.
+     */
+    template <typename Visitor> void getInRadius(const Vec &center, const float radius, Visitor &&visit) const {
+        const float bound = Metric::term(radius);
+        const auto classify = [&center, bound](const Box &bb) {
+            if (reducedDistance<Metric, D>(bb, center) > bound) {
+                return Intersection::OUTSIDE;
+            }
+            const auto furthestCorner = glm::max(glm::abs(center - bb.min), glm::abs(center - bb.max));
+            if (reducedLength<Metric, D>(furthestCorner) <= bound) {
+                return Intersection::INSIDE;
             }
+            return Intersection::INTERSECTING;
+        };
+        const auto contains = [&center, bound](const Vec &point) {
+            return reducedDistance<Metric, D>(point, center) <= bound;
+        };
+        for (const auto &tree : trees) {
+            tree.visitRange(classify, contains, visit);
+        }
+    }
 
-            traversalFunc(current);
+    template <typename Visitor> void getInBox(const Box &box, Visitor &&visit) const {
+        const auto classify = [&box](const Box &bb) {
+            if (!box.intersects(bb)) {
+                return Intersection::OUTSIDE;
+            }
+            if (box.contains(bb)) {
+                return Intersection::INSIDE;
+            }
+            return Intersection::INTERSECTING;
+        };
+        const auto contains = [&box](const Vec &point) { return box.contains(point); };
+        for (const auto &tree : trees) {
+            tree.visitRange(classify, contains, visit);
+        }
+    }
 
-            stack.push_back(current->left);
-            stack.push_back(current->right);
+    template <typename Visitor>
+    void getInFrustum(const Frustum &frustum, Visitor &&visit) const
+        requires(D == 3)
+    {
+        const auto classify = [&frustum](const BoundingBox3 &bb) { return frustum.intersect(bb); };
+        const auto contains = [&frustum](const glm::vec3 &point) { return frustum.contains(point); };
+        for (const auto &tree : trees) {
+            tree.visitRange(classify, contains, visit);
         }
     }
 
-    void traversePostOrder(const std::function<void(std::shared_ptr<Node>)> &traversalFunc) const {
-        std::vector<std::shared_ptr<Node>> stack = {};
-        std::shared_ptr<Node> current = root;
-        while (true) {
-            while (current != nullptr) {
-                if (current->right != nullptr) {
-                    stack.push_back(current->right);
-                }
-                stack.push_back(current);
+    void traversePreOrder(const TraversalFunc &traversalFunc) const {
+        for (const auto &tree : trees) {
+            tree.traversePreOrder([&tree, &traversalFunc](unsigned int node) { traversalFunc(tree, node); });
+        }
+    }
 
-                current = current->left;
-            }
+    void traversePostOrder(const TraversalFunc &traversalFunc) const {
+        for (const auto &tree : trees) {
+            tree.traversePostOrder([&tree, &traversalFunc](unsigned int node) { traversalFunc(tree, node); });
+        }
+    }
 
-            current = stack.back();
-            stack.pop_back();
+    void traverseInOrder(const TraversalFunc &traversalFunc) const {
+        for (const auto &tree : trees) {
+            tree.traverseInOrder([&tree, &traversalFunc](unsigned int node) { traversalFunc(tree, node); });
+        }
+    }
 
-            if (current->right != nullptr && (!stack.empty() && stack[stack.size() - 1] == current->right)) {
-                stack.pop_back();
-                stack.push_back(current);
-                current = current->right;
-            } else {
-                traversalFunc(current);
-                current = nullptr;
+    /*
+     * Writes all trees to a file that can be opened again with openMapped.
+     * The values are written as they are in memory, so this is only possible for trivially copyable types.
+     */
+    bool save(const std::string &filePath) const
+        requires std::is_trivially_copyable_v<T>
+    {
+        auto fs = std::ofstream(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!fs.is_open()) {
+            std::cerr << "Failed to open file for writing: " << filePath << std::endl;
+            return false;
+        }
+
+        QuadTreeFileHeader header = {};
+        header.dimension = D;
+        header.nodeSize = sizeof(Node);
+        header.valueSize = sizeof(T);
+        header.maxElementsPerNode = maxElementsPerNode;
+        header.treeCount = trees.size();
+
+        uint64_t offset = sizeof(QuadTreeFileHeader) + trees.size() * sizeof(QuadTreeFileTree);
+        const auto reserve = [&offset](uint64_t sizeInBytes) {
+            offset = (offset + QUAD_TREE_FILE_ALIGNMENT - 1) / QUAD_TREE_FILE_ALIGNMENT * QUAD_TREE_FILE_ALIGNMENT;
+            const auto result = offset;
+            offset += sizeInBytes;
+            return result;
+        };
+
+        std::vector<QuadTreeFileTree> fileTrees = {};
+        for (const auto &tree : trees) {
+            auto &fileTree = fileTrees.emplace_back();
+            fileTree.nodeCount = tree.nodes.size();
+            fileTree.elementCount = tree.size();
+            fileTree.nodesOffset = reserve(tree.nodes.size_bytes());
+            for (glm::length_t axis = 0; axis < D; axis++) {
+                fileTree.coordOffsets[axis] = reserve(tree.coords[axis].size_bytes());
             }
+            fileTree.valuesOffset = reserve(tree.values.size_bytes());
+        }
 
-            if (stack.empty()) {
-                break;
+        fs.write(reinterpret_cast<const char *>(&header), sizeof(header));
+        fs.write(reinterpret_cast<const char *>(fileTrees.data()), fileTrees.size() * sizeof(QuadTreeFileTree));
+
+        const auto writeAt = [&fs](uint64_t sectionOffset, const void *data, uint64_t sizeInBytes) {
+            const auto padding = sectionOffset - static_cast<uint64_t>(fs.tellp());
+            for (uint64_t i = 0; i < padding; i++) {
+                fs.put(0);
+            }
+            fs.write(reinterpret_cast<const char *>(data), sizeInBytes);
+        };
+        for (unsigned int i = 0; i < trees.size(); i++) {
+            const auto &tree = trees[i];
+            writeAt(fileTrees[i].nodesOffset, tree.nodes.data(), tree.nodes.size_bytes());
+            for (glm::length_t axis = 0; axis < D; axis++) {
+                writeAt(fileTrees[i].coordOffsets[axis], tree.coords[axis].data(), tree.coords[axis].size_bytes());
             }
+            writeAt(fileTrees[i].valuesOffset, tree.values.data(), tree.values.size_bytes());
         }
+
+        if (!fs.good()) {
+            std::cerr << "Failed to write quad tree to " << filePath << std::endl;
+            return false;
+        }
+        return true;
     }
 
-    void traverseInOrder(const std::function<void(std::shared_ptr<Node>)> &traversalFunc) const {
-        std::vector<std::shared_ptr<Node>> stack = {};
-        std::shared_ptr<Node> current = root;
-        while (true) {
-            if (current != nullptr) {
-                stack.push_back(current);
-                current = current->left;
-            } else if (!stack.empty()) {
-                current = stack.back();
-                stack.pop_back();
-                if (current == nullptr) {
-                    continue;
-                }
+    /*
+     * Maps a file that was written by save into memory.
+     * The trees are queried directly from the mapping, nothing is copied or rebuilt.
+     * Inserting into the returned tree works as usual, the mapped trees are merged into new in-memory trees.
+     */
+    static std::optional<QuadTree> openMapped(const std::string &filePath)
+        requires std::is_trivially_copyable_v<T>
+    {
+        static_assert(alignof(T) <= QUAD_TREE_FILE_ALIGNMENT);
+
+        const auto file = MappedFile::open(filePath);
+        if (file == nullptr) {
+            return {};
+        }
 
-                traversalFunc(current);
+        QuadTreeFileHeader header = {};
+        if (file->size() < sizeof(header)) {
+            std::cerr << "File is too small to contain a quad tree: " << filePath << std::endl;
+            return {};
+        }
+        const QuadTreeFileHeader expected = {};
+        std::memcpy(&header, file->data(), sizeof(header));
+        if (std::memcmp(header.magic, expected.magic, sizeof(header.magic)) != 0 ||
+            header.version != expected.version) {
+            std::cerr << "File does not contain a quad tree of version " << QUAD_TREE_FILE_VERSION << ": " << filePath
+                      << std::endl;
+            return {};
+        }
+        if (header.dimension != D || header.nodeSize != sizeof(Node) || header.valueSize != sizeof(T)) {
+            std::cerr << "Quad tree in " << filePath << " was saved with a different dimension, node or value type"
+                      << std::endl;
+            return {};
+        }
+        if (header.treeCount > (file->size() - sizeof(header)) / sizeof(QuadTreeFileTree)) {
+            std::cerr << "Quad tree in " << filePath << " is truncated" << std::endl;
+            return {};
+        }
 
-                current = current->right;
-            } else {
-                break;
+        const auto isValidSection = [&file](uint64_t offset, uint64_t count, uint64_t elementSize) {
+            return offset % QUAD_TREE_FILE_ALIGNMENT == 0 && offset <= file->size() &&
+                   count <= (file->size() - offset) / elementSize;
+        };
+        const auto *fileTrees = reinterpret_cast<const QuadTreeFileTree *>(file->data() + sizeof(header));
+
+        auto result = QuadTree(header.maxElementsPerNode);
+        for (uint64_t i = 0; i < header.treeCount; i++) {
+            QuadTreeFileTree fileTree = {};
+            std::memcpy(&fileTree, fileTrees + i, sizeof(fileTree));
+            // a complete binary tree with at least the root, whose node indices fit into an unsigned int
+            bool valid = fileTree.nodeCount >= 1 && fileTree.nodeCount <= std::numeric_limits<unsigned int>::max() &&
+                         std::has_single_bit(fileTree.nodeCount + 1) &&
+                         fileTree.elementCount <= std::numeric_limits<unsigned int>::max() &&
+                         isValidSection(fileTree.nodesOffset, fileTree.nodeCount, sizeof(Node)) &&
+                         isValidSection(fileTree.valuesOffset, fileTree.elementCount, sizeof(T));
+            for (glm::length_t axis = 0; axis < D; axis++) {
+                valid = valid && isValidSection(fileTree.coordOffsets[axis], fileTree.elementCount, sizeof(float));
+            }
+
+            const auto *base = file->data();
+            const auto nodes =
+                  valid ? std::span(reinterpret_cast<const Node *>(base + fileTree.nodesOffset), fileTree.nodeCount)
+                        : std::span<const Node>();
+            // queries index the elements with the ranges of the nodes without checking them
+            valid = valid && std::all_of(nodes.begin(), nodes.end(), [&fileTree](const Node &node) {
+                        return node.begin <= node.end && node.end <= fileTree.elementCount;
+                    });
+            if (!valid) {
+                std::cerr << "Tree " << i << " of quad tree in " << filePath << " is corrupted" << std::endl;
+                return {};
             }
+
+            std::array<std::span<const float>, D> coords = {};
+            for (glm::length_t axis = 0; axis < D; axis++) {
+                const auto *axisCoords = reinterpret_cast<const float *>(base + fileTree.coordOffsets[axis]);
+                coords[axis] = std::span(axisCoords, fileTree.elementCount);
+            }
+            result.trees.emplace_back(
+                  file, nodes, coords,
+                  std::span(reinterpret_cast<const T *>(base + fileTree.valuesOffset), fileTree.elementCount));
         }
+
+        return result;
     }
 
     unsigned int maxElementsPerNode = DEFAULT_MAX_ELEMENTS_PER_NODE;
-    std::vector<Element> elements = {};
-    std::shared_ptr<Node> root = nullptr;
+    std::vector<Tree> trees = {};
+
+  private:
+    void search(const Vec &query, const unsigned int k, const QuadTreeSearchParams &params,
+                std::vector<Candidate> &closestElements, std::vector<unsigned int> &nodeStack) const {
+        // the leaf budget is shared by all trees, the biggest ones are searched first
+        unsigned int visitedLeaves = 0;
+        for (const auto &tree : trees) {
+            tree.search(query, k, params, closestElements, nodeStack, visitedLeaves);
+        }
+        std::sort_heap(closestElements.begin(), closestElements.end(), isCloser);
+    }
 };
@@ -2,49 +2,48 @@
 
 #include <glm/glm.hpp>
 #include <algorithm>
+#include <limits>
 
-#define UPDATE(left, op, right)                                                                                        \
-    if (left op right) {                                                                                               \
-        left = right;                                                                                                  \
-    }
+template <glm::length_t D> struct BoundingBox {
+    using Vec = glm::vec<D, float>;
+
+    Vec min = Vec(std::numeric_limits<float>::max());
+    Vec max = Vec(std::numeric_limits<float>::lowest());
 
-struct BoundingBox3 {
-    glm::vec3 min = {
-          std::numeric_limits<float>::max(), //
-          std::numeric_limits<float>::max(), //
-          std::numeric_limits<float>::max()  //
-    };
-    glm::vec3 max = {
-          std::numeric_limits<float>::min(), //
-          std::numeric_limits<float>::min(), //
-          std::numeric_limits<float>::min()  //
-    };
-
-    void update(const glm::vec3 &point) {
-        UPDATE(min.x, >, point.x)
-        UPDATE(min.y, >, point.y)
-        UPDATE(min.z, >, point.z)
-
-        UPDATE(max.x, <, point.x)
-        UPDATE(max.y, <, point.y)
-        UPDATE(max.z, <, point.z)
+    void update(const Vec &point) {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
     }
 
-    void update(const BoundingBox3 &bb){
-          UPDATE(min.x, >, bb.min.x) //
-          UPDATE(min.y, >, bb.min.y) //
-          UPDATE(min.z, >, bb.min.z) //
-          UPDATE(max.x, <, bb.max.x) //
-          UPDATE(max.y, <, bb.max.y) //
-          UPDATE(max.z, <, bb.max.z) //
+    void update(const BoundingBox &bb) {
+        min = glm::min(min, bb.min);
+        max = glm::max(max, bb.max);
     }
 
-    glm::vec3 closestPointOnSurface(const glm::vec3 &point) const {
-        float x = std::min(max.x, std::max(point.x, min.x));
-        float y = std::min(max.y, std::max(point.y, min.x));
-        float z = std::min(max.z, std::max(point.z, min.x));
-        return {x, y, z};
+    Vec closestPointOnSurface(const Vec &point) const { return glm::clamp(point, min, max); }
+
+    Vec center() const { return (min + max) / 2.0F; }
+
+    bool contains(const Vec &point) const {
+        for (glm::length_t i = 0; i < D; i++) {
+            if (point[i] < min[i] || point[i] > max[i]) {
+                return false;
+            }
+        }
+        return true;
     }
 
-    glm::vec3 center() const { return (min + max) / 2.0F; }
+    bool contains(const BoundingBox &bb) const { return contains(bb.min) && contains(bb.max); }
+
+    bool intersects(const BoundingBox &bb) const {
+        for (glm::length_t i = 0; i < D; i++) {
+            if (bb.max[i] < min[i] || bb.min[i] > max[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
 };
+
+using BoundingBox2 = BoundingBox<2>;
+using BoundingBox3 = BoundingBox<3>;
@@ -0,0 +1,9 @@
+#pragma once
+
+/*
+ * Checks for the instruction sets that code which was compiled for them separately can use at runtime.
+ * They are false on every CPU that is not x86.
+ */
+bool cpuSupportsSse3();
+bool cpuSupportsAvx2();
+bool cpuSupportsFma();
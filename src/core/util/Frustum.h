@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <glm/glm.hpp>
+
+#include "BoundingBox.h"
+
+/**
+ * Six planes (left, right, bottom, top, near, far) stored as (normal, distance).
+ * A point p is inside of a plane if dot(normal, p) + distance >= 0.
+ */
+struct Frustum {
+    enum class Intersection { OUTSIDE, INTERSECTING, INSIDE };
+
+    std::array<glm::vec4, 6> planes = {};
+
+    /**
+     * Extracts the planes from a combined projection * view matrix (Gribb/Hartmann).
+     */
+    static Frustum fromMatrix(const glm::mat4 &viewProjection) {
+        const auto row = [&viewProjection](int i) {
+            return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        };
+
+        Frustum result = {};
+        result.planes[0] = row(3) + row(0);
+        result.planes[1] = row(3) - row(0);
+        result.planes[2] = row(3) + row(1);
+        result.planes[3] = row(3) - row(1);
+        result.planes[4] = row(3) + row(2);
+        result.planes[5] = row(3) - row(2);
+        return result;
+    }
+
+    bool contains(const glm::vec3 &point) const {
+        for (const auto &plane : planes) {
+            if (plane.x * point.x + plane.y * point.y + plane.z * point.z + plane.w < 0.0F) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    Intersection intersect(const BoundingBox3 &bb) const {
+        auto result = Intersection::INSIDE;
+        for (const auto &plane : planes) {
+            // the corners of the box that are the furthest along and against the plane normal
+            const auto positive = glm::vec3(plane.x >= 0.0F ? bb.max.x : bb.min.x, //
+                                            plane.y >= 0.0F ? bb.max.y : bb.min.y, //
+                                            plane.z >= 0.0F ? bb.max.z : bb.min.z);
+            const auto negative = glm::vec3(plane.x >= 0.0F ? bb.min.x : bb.max.x, //
+                                            plane.y >= 0.0F ? bb.min.y : bb.max.y, //
+                                            plane.z >= 0.0F ? bb.min.z : bb.max.z);
+            if (plane.x * positive.x + plane.y * positive.y + plane.z * positive.z + plane.w < 0.0F) {
+                return Intersection::OUTSIDE;
+            }
+            if (plane.x * negative.x + plane.y * negative.y + plane.z * negative.z + plane.w < 0.0F) {
+                result = Intersection::INTERSECTING;
+            }
+        }
+        return result;
+    }
+};
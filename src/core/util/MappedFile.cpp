@@ -0,0 +1,106 @@
+#include "MappedFile.h"
+
+#include <iostream>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string &filePath) {
+    auto result = std::shared_ptr<MappedFile>(new MappedFile());
+    result->fileHandle = CreateFileA(filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                                     FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (result->fileHandle == INVALID_HANDLE_VALUE) {
+        result->fileHandle = nullptr;
+        std::cerr << "Failed to open file for mapping: " << filePath << std::endl;
+        return nullptr;
+    }
+
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(result->fileHandle, &fileSize)) {
+        std::cerr << "Failed to get size of file: " << filePath << std::endl;
+        return nullptr;
+    }
+    result->mappedSize = static_cast<size_t>(fileSize.QuadPart);
+    if (result->mappedSize == 0) {
+        return result;
+    }
+
+    result->mappingHandle = CreateFileMappingA(result->fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (result->mappingHandle == nullptr) {
+        std::cerr << "Failed to create file mapping: " << filePath << std::endl;
+        return nullptr;
+    }
+
+    result->mappedData = static_cast<const char *>(MapViewOfFile(result->mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (result->mappedData == nullptr) {
+        std::cerr << "Failed to map file: " << filePath << std::endl;
+        return nullptr;
+    }
+
+    return result;
+}
+
+MappedFile::~MappedFile() {
+    if (mappedData != nullptr) {
+        UnmapViewOfFile(mappedData);
+    }
+    if (mappingHandle != nullptr) {
+        CloseHandle(mappingHandle);
+    }
+    if (fileHandle != nullptr) {
+        CloseHandle(fileHandle);
+    }
+}
+
+#else
+
+std::shared_ptr<MappedFile> MappedFile::open(const std::string &filePath) {
+    int fd = ::open(filePath.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "Failed to open file for mapping: " << filePath << std::endl;
+        return nullptr;
+    }
+
+    struct stat fileStat = {};
+    if (fstat(fd, &fileStat) != 0) {
+        std::cerr << "Failed to get size of file: " << filePath << std::endl;
+        close(fd);
+        return nullptr;
+    }
+
+    auto result = std::shared_ptr<MappedFile>(new MappedFile());
+    result->mappedSize = static_cast<size_t>(fileStat.st_size);
+    if (result->mappedSize == 0) {
+        close(fd);
+        return result;
+    }
+
+    void *mapping = mmap(nullptr, result->mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps its own reference to the file
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Failed to map file: " << filePath << std::endl;
+        result->mappedSize = 0;
+        return nullptr;
+    }
+
+    result->mappedData = static_cast<const char *>(mapping);
+    return result;
+}
+
+MappedFile::~MappedFile() {
+    if (mappedData != nullptr) {
+        munmap(const_cast<char *>(mappedData), mappedSize);
+    }
+}
+
+#endif
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+/**
+ * A read-only memory mapping of a whole file.
+ * The mapping stays valid for as long as the MappedFile is alive.
+ */
+class MappedFile {
+  public:
+    static std::shared_ptr<MappedFile> open(const std::string &filePath);
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile();
+
+    const char *data() const { return mappedData; }
+    size_t size() const { return mappedSize; }
+
+  private:
+    MappedFile() = default;
+
+    const char *mappedData = nullptr;
+    size_t mappedSize = 0;
+#ifdef _WIN32
+    void *fileHandle = nullptr;
+    void *mappingHandle = nullptr;
+#endif
+};
@@ -1,217 +1,637 @@
 #include "zip.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
-#include <sstream>
+#include <limits>
+#include <thread>
 #include <zlib.h>
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 namespace zip {
 
-#define ENSURE_FS_IS_GOOD(fs, msg)                                                                                     \
-    if (!(fs).good()) {                                                                                                \
+#define ENSURE_READ(condition, msg)                                                                                    \
+    if (!(condition)) {                                                                                                \
         std::cerr << msg << std::endl;                                                                                 \
         return {};                                                                                                     \
     }
 
-template <typename T> std::optional<LocalFileHeader> readLocalFileHeader(T &fs) {
-    LocalFileHeader fileHeader = {};
-    auto fileHeaderSize = fileHeader.get_struct_size();
+// the end of central directory record is followed by a comment of at most this many bytes
+constexpr uint64_t MAX_ZIP_FILE_COMMENT_LENGTH = 0xFFFF;
+
+// sizes and offsets that do not fit into 4 bytes are set to this, their value is then in a zip64 structure
+constexpr uint32_t ZIP64_PLACEHOLDER = 0xFFFFFFFF;
+constexpr uint16_t ZIP64_EXTENDED_INFORMATION_HEADER_ID = 0x0001;
+
+// memory for the content is only reserved up front for up to this many times the compressed size,
+// because the uncompressed size comes from the archive and is not checked before the file is inflated
+constexpr uint64_t MAX_RESERVED_COMPRESSION_RATIO = 16;
+
+/*
+ * Reads the archive in place. The fixed size parts of the headers are copied, because they are not aligned,
+ * everything else is only pointed to. All reads check that they stay inside of the archive.
+ */
+struct Reader {
+    const char *data = nullptr;
+    uint64_t size = 0;
+    uint64_t position = 0;
+
+    bool seek(uint64_t newPosition) {
+        if (newPosition > size) {
+            return false;
+        }
+        position = newPosition;
+        return true;
+    }
+
+    bool read(void *destination, uint64_t count) {
+        if (count > size - position) {
+            return false;
+        }
+        std::memcpy(destination, data + position, count);
+        position += count;
+        return true;
+    }
+
+    // the next count bytes, or nullptr if the archive ends before that
+    const char *view(uint64_t count) {
+        if (count > size - position) {
+            return nullptr;
+        }
+        const auto *result = data + position;
+        position += count;
+        return result;
+    }
+};
 
-    fs.read((char *)&fileHeader, fileHeaderSize);
-    ENSURE_FS_IS_GOOD(fs, "Failed to read local file header");
+std::optional<LocalFileHeader> readLocalFileHeader(Reader &reader) {
+    LocalFileHeader fileHeader = {};
+    ENSURE_READ(reader.read(&fileHeader, fileHeader.get_struct_size()), "Failed to read local file header");
 
     if (fileHeader.local_file_header_signature != 0x04034b50) {
         std::cerr << "Signature of local file header is not 0x04034b50" << std::endl;
         return {};
     }
 
-    fileHeader.file_name = (char *)malloc(fileHeader.file_name_length);
-    fs.read(fileHeader.file_name, fileHeader.file_name_length);
-    ENSURE_FS_IS_GOOD(fs, "Failed to read file name in local file header");
+    fileHeader.file_name = reader.view(fileHeader.file_name_length);
+    ENSURE_READ(fileHeader.file_name != nullptr, "Failed to read file name in local file header");
 
-    fileHeader.extra_field = (char *)malloc(fileHeader.extra_field_length);
-    fs.read(fileHeader.extra_field, fileHeader.extra_field_length);
-    ENSURE_FS_IS_GOOD(fs, "Failed to read extra field in local file header");
+    fileHeader.extra_field = reader.view(fileHeader.extra_field_length);
+    ENSURE_READ(fileHeader.extra_field != nullptr, "Failed to read extra field in local file header");
 
     return fileHeader;
 }
 
-template <typename T> std::optional<CentralDirectorySignature> readCentralDirectorySignature(T &fs) {
+std::optional<CentralDirectorySignature> readCentralDirectorySignature(Reader &reader) {
     CentralDirectorySignature result = {};
-    fs.read((char *)&result, result.get_struct_size());
-    ENSURE_FS_IS_GOOD(fs, "Failed to read central directory digital signature");
+    ENSURE_READ(reader.read(&result, result.get_struct_size()), "Failed to read central directory digital signature");
 
     if (result.header_signature != 0x05054b50) {
         // the signature is not always present
         return CentralDirectorySignature();
     }
 
-    result.signature_data = (char *)malloc(result.size_of_data);
-    fs.read(result.signature_data, result.size_of_data);
-    ENSURE_FS_IS_GOOD(fs, "Failed to read signature data in central directory signature");
+    result.signature_data = reader.view(result.size_of_data);
+    ENSURE_READ(result.signature_data != nullptr, "Failed to read signature data in central directory signature");
 
     return result;
 }
 
-template <typename T>
-std::optional<CentralDirectory> readCentralDirectory(T &fs,
-                                                     const EndOfCentralDirectoryRecord &endOfCentralDirectoryRecord) {
-    if (endOfCentralDirectoryRecord.number_of_the_disk_with_the_start_if_the_central_directory !=
-        endOfCentralDirectoryRecord.number_of_this_disk) {
-        std::cerr << "Multiple disks are not supported" << std::endl;
-        return {};
-    }
-
-    fs.seekg(endOfCentralDirectoryRecord.offset_of_start_of_central_directory_with_respect_to_the_starting_disk_number,
-             std::ios_base::beg);
+std::optional<CentralDirectory> readCentralDirectory(Reader &reader, uint64_t offset, uint64_t entryCount) {
+    ENSURE_READ(reader.seek(offset), "Offset of central directory is outside of the archive");
 
     CentralDirectory centralDirectory = {};
-    for (int i = 0; i < endOfCentralDirectoryRecord.total_number_of_entries_in_the_central_directory_on_this_disk;
-         i++) {
+    // checking the count before reserving, so that a broken count can not ask for more memory than the archive has
+    ENSURE_READ(entryCount <= (reader.size - offset) / CentralFileHeader().get_struct_size(),
+                "Central directory with " << entryCount << " entries does not fit into the archive");
+    centralDirectory.file_headers.reserve(entryCount);
+    for (uint64_t i = 0; i < entryCount; i++) {
         auto &fileHeader = centralDirectory.file_headers.emplace_back();
-        fs.read((char *)&fileHeader, fileHeader.get_struct_size());
-        ENSURE_FS_IS_GOOD(fs, "Failed to read central file header " << i);
+        ENSURE_READ(reader.read(&fileHeader, fileHeader.get_struct_size()), "Failed to read central file header " << i);
 
         if (fileHeader.central_file_header_signature != 0x02014b50) {
             std::cerr << "Signature of central file header " << i << " is not 0x02014b50" << std::endl;
             return {};
         }
 
-        fileHeader.file_name = (char *)malloc(fileHeader.file_name_length);
-        fs.read(fileHeader.file_name, fileHeader.file_name_length);
-        ENSURE_FS_IS_GOOD(fs, "Failed to read file name in central file header");
+        fileHeader.file_name = reader.view(fileHeader.file_name_length);
+        ENSURE_READ(fileHeader.file_name != nullptr, "Failed to read file name in central file header");
 
-        fileHeader.extra_field = (char *)malloc(fileHeader.extra_field_length);
-        fs.read(fileHeader.extra_field, fileHeader.extra_field_length);
-        ENSURE_FS_IS_GOOD(fs, "Failed to read extra field in central file header");
+        fileHeader.extra_field = reader.view(fileHeader.extra_field_length);
+        ENSURE_READ(fileHeader.extra_field != nullptr, "Failed to read extra field in central file header");
 
-        fileHeader.file_comment = (char *)malloc(fileHeader.file_comment_length);
-        fs.read(fileHeader.file_comment, fileHeader.file_comment_length);
-        ENSURE_FS_IS_GOOD(fs, "Failed to read file comment in central file header");
+        fileHeader.file_comment = reader.view(fileHeader.file_comment_length);
+        ENSURE_READ(fileHeader.file_comment != nullptr, "Failed to read file comment in central file header");
     }
 
-    auto digitalSignatureOpt = readCentralDirectorySignature(fs);
+    auto digitalSignatureOpt = readCentralDirectorySignature(reader);
     if (!digitalSignatureOpt.has_value()) {
         std::cerr << "Failed to read digital signature in central directory" << std::endl;
         return {};
     }
+    centralDirectory.digital_signature = digitalSignatureOpt.value();
 
     return centralDirectory;
 }
 
-template <typename T> std::optional<EndOfCentralDirectoryRecord> readEndOfCentralDirectoryRecord(T &fs) {
+std::optional<EndOfCentralDirectoryRecord> readEndOfCentralDirectoryRecord(Reader &reader, uint64_t &position) {
     EndOfCentralDirectoryRecord result = {};
     auto endOfCentralDirectoryRecordSize = result.get_struct_size();
+    ENSURE_READ(reader.size >= endOfCentralDirectoryRecordSize, "Archive is too small to be a zip file");
 
-    // seek backwards from the end to find the signature
-    fs.seekg(-1 * endOfCentralDirectoryRecordSize, std::ios_base::end);
-
+    // search backwards from the end for the signature, the record can only be followed by the zip file comment
+    const auto lastPosition = reader.size - endOfCentralDirectoryRecordSize;
+    position = lastPosition;
     while (true) {
         uint32_t signature = 0;
-        fs.read((char *)&signature, sizeof(signature));
-        ENSURE_FS_IS_GOOD(fs, "Failed to read end of central directory signature");
-
+        std::memcpy(&signature, reader.data + position, sizeof(signature));
         if (signature == 0x06054b50) {
             break;
         }
 
-        fs.seekg(-1 * (sizeof(signature) + 1), std::ios_base::cur);
+        if (position == 0 || lastPosition - position >= MAX_ZIP_FILE_COMMENT_LENGTH) {
+            std::cerr << "Failed to find end of central directory signature" << std::endl;
+            return {};
+        }
+        position--;
     }
 
-    fs.seekg(-1 * sizeof(result.end_of_central_directory_signature), std::ios_base::cur);
-    fs.read((char *)&result, endOfCentralDirectoryRecordSize);
-    ENSURE_FS_IS_GOOD(fs, "Failed to read end of central directory record");
+    reader.seek(position);
+    ENSURE_READ(reader.read(&result, endOfCentralDirectoryRecordSize),
+                "Failed to read end of central directory record");
+
+    result.zip_file_comment = reader.view(result.zip_file_comment_length);
+    ENSURE_READ(result.zip_file_comment != nullptr, "Failed to read zip file comment");
 
     return result;
 }
 
-template <typename T> std::optional<File> readFile(T &fs, const CentralFileHeader &central_file_header) {
-    fs.seekg(central_file_header.relative_offset_of_local_header, std::ios_base::beg);
-    auto localFileHeaderOpt = readLocalFileHeader(fs);
-    if (!localFileHeaderOpt.has_value()) {
+std::optional<Zip64EndOfCentralDirectoryRecord>
+readZip64EndOfCentralDirectoryRecord(Reader &reader, uint64_t endOfCentralDirectoryRecordPosition) {
+    // the locator directly precedes the end of central directory record, but only in zip64 archives
+    Zip64EndOfCentralDirectoryLocator locator = {};
+    if (endOfCentralDirectoryRecordPosition < locator.get_struct_size()) {
+        return Zip64EndOfCentralDirectoryRecord();
+    }
+    reader.seek(endOfCentralDirectoryRecordPosition - locator.get_struct_size());
+    ENSURE_READ(reader.read(&locator, locator.get_struct_size()),
+                "Failed to read zip64 end of central directory locator");
+    if (locator.zip64_end_of_central_directory_locator_signature != 0x07064b50) {
+        return Zip64EndOfCentralDirectoryRecord();
+    }
+    if (locator.total_number_of_disks > 1) {
+        std::cerr << "Multiple disks are not supported" << std::endl;
         return {};
     }
 
-    File result = {};
-    result.local_file_header = localFileHeaderOpt.value();
+    Zip64EndOfCentralDirectoryRecord result = {};
+    ENSURE_READ(reader.seek(locator.relative_offset_of_the_zip64_end_of_central_directory_record),
+                "Offset of zip64 end of central directory record is outside of the archive");
+    ENSURE_READ(reader.read(&result, result.get_struct_size()), "Failed to read zip64 end of central directory record");
 
-    uint32_t file_size = 0;
-    if (result.local_file_header.general_purpose_bit_flag.is_data_descriptor_present) {
-        file_size = central_file_header.compressed_size;
-    } else {
-        file_size = result.local_file_header.compressed_size;
+    if (result.zip64_end_of_central_directory_signature != 0x06064b50) {
+        std::cerr << "Signature of zip64 end of central directory record is not 0x06064b50" << std::endl;
+        return {};
     }
 
-    result.file_data = (char *)malloc(file_size);
-    fs.read(result.file_data, file_size);
-    ENSURE_FS_IS_GOOD(fs, "Failed to read file data");
+    return result;
+}
 
-    if (result.local_file_header.general_purpose_bit_flag.is_data_descriptor_present) {
-        fs.read((char *)&result.data_descriptor, result.data_descriptor.get_struct_size());
-        ENSURE_FS_IS_GOOD(fs, "Failed to read data descriptor");
+/*
+ * The extra field is a list of blocks with a 2 byte id and a 2 byte size.
+ * The zip64 extended information block holds the uncompressed size, the compressed size and the offset of the local
+ * file header in this order, but only the ones that are set to the placeholder in the central file header.
+ */
+bool readZip64ExtendedInformation(const CentralFileHeader &central_file_header, File &file) {
+    auto reader = Reader{central_file_header.extra_field, central_file_header.extra_field_length};
+    while (reader.position < reader.size) {
+        uint16_t headerId = 0;
+        uint16_t dataSize = 0;
+        ENSURE_READ(reader.read(&headerId, sizeof(headerId)) && reader.read(&dataSize, sizeof(dataSize)),
+                    "Failed to read extra field block of " << central_file_header.get_file_name());
+        const auto *data = reader.view(dataSize);
+        ENSURE_READ(data != nullptr, "Failed to read extra field block of " << central_file_header.get_file_name());
+        if (headerId != ZIP64_EXTENDED_INFORMATION_HEADER_ID) {
+            continue;
+        }
 
-        if (result.data_descriptor.data_descriptor_signature != 0x08074b50) {
-            std::cerr << "Signature of data descriptor is not 0x08074b50" << std::endl;
+        auto blockReader = Reader{data, dataSize};
+        if (central_file_header.uncompressed_size == ZIP64_PLACEHOLDER) {
+            ENSURE_READ(blockReader.read(&file.uncompressed_size, sizeof(file.uncompressed_size)),
+                        "Failed to read zip64 uncompressed size of " << central_file_header.get_file_name());
+        }
+        if (central_file_header.compressed_size == ZIP64_PLACEHOLDER) {
+            ENSURE_READ(blockReader.read(&file.compressed_size, sizeof(file.compressed_size)),
+                        "Failed to read zip64 compressed size of " << central_file_header.get_file_name());
+        }
+        if (central_file_header.relative_offset_of_local_header == ZIP64_PLACEHOLDER) {
+            ENSURE_READ(blockReader.read(&file.local_file_header_offset, sizeof(file.local_file_header_offset)),
+                        "Failed to read zip64 offset of local file header of " << central_file_header.get_file_name());
+        }
+        return true;
+    }
+
+    std::cerr << "Failed to find zip64 extended information of " << central_file_header.get_file_name() << std::endl;
+    return false;
+}
+
+// stored content is read in place, so it has to be exactly as large as the file data in the archive
+bool hasValidStoredSize(const File &file, CompressionMethod compressionMethod) {
+    if (compressionMethod == CompressionMethod::NO_COMPRESSION && file.compressed_size != file.uncompressed_size) {
+        std::cerr << "Stored file " << file.get_file_name() << " has a compressed size of " << file.compressed_size
+                  << " and an uncompressed size of " << file.uncompressed_size << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// how much of the uncompressed size can be allocated before inflating, files that compress better grow as needed
+uint64_t getReservedSize(const File &file) {
+    return std::min(file.uncompressed_size, file.compressed_size * MAX_RESERVED_COMPRESSION_RATIO);
+}
+
+std::optional<File> createFile(const CentralFileHeader &central_file_header, std::span<const char> archive) {
+    File result = {};
+    result.archive = archive;
+    result.compressed_size = central_file_header.compressed_size;
+    result.uncompressed_size = central_file_header.uncompressed_size;
+    result.local_file_header_offset = central_file_header.relative_offset_of_local_header;
+    if (central_file_header.compressed_size == ZIP64_PLACEHOLDER ||
+        central_file_header.uncompressed_size == ZIP64_PLACEHOLDER ||
+        central_file_header.relative_offset_of_local_header == ZIP64_PLACEHOLDER) {
+        if (!readZip64ExtendedInformation(central_file_header, result)) {
             return {};
         }
     }
 
+    auto &localFileHeader = result.local_file_header;
+    localFileHeader.local_file_header_signature = 0x04034b50;
+    localFileHeader.version_needed_to_extract = central_file_header.version_needed_to_extract;
+    localFileHeader.general_purpose_bit_flag = central_file_header.general_purpose_bit_flag;
+    localFileHeader.compression_method = central_file_header.compression_method;
+    localFileHeader.last_mod_file_time = central_file_header.last_mod_file_time;
+    localFileHeader.last_mod_file_data = central_file_header.last_mod_file_date;
+    localFileHeader.crc32 = central_file_header.crc_32;
+    localFileHeader.compressed_size = central_file_header.compressed_size;
+    localFileHeader.uncompressed_size = central_file_header.uncompressed_size;
+    localFileHeader.file_name_length = central_file_header.file_name_length;
+    localFileHeader.file_name = central_file_header.file_name;
+    if (!hasValidStoredSize(result, localFileHeader.get_compression_method())) {
+        return {};
+    }
     return result;
 }
 
-template <typename T> std::optional<Container> open(T &fs) {
-    auto endOfCentralDirectoryRecordOpt = readEndOfCentralDirectoryRecord(fs);
+bool loadFile(File &file) {
+    auto reader = Reader{file.archive.data(), file.archive.size()};
+    ENSURE_READ(reader.seek(file.local_file_header_offset), "Offset of local file header is outside of the archive");
+    auto localFileHeaderOpt = readLocalFileHeader(reader);
+    if (!localFileHeaderOpt.has_value()) {
+        return false;
+    }
+
+    // the sizes in the local file header are 0, if they are stored in the data descriptor after the file data,
+    // so the ones from the central file header are kept
+    const auto compressedSize = file.local_file_header.compressed_size;
+    const auto uncompressedSize = file.local_file_header.uncompressed_size;
+    file.local_file_header = localFileHeaderOpt.value();
+    file.local_file_header.compressed_size = compressedSize;
+    file.local_file_header.uncompressed_size = uncompressedSize;
+    // the compression method of the local file header is the one that is used from now on
+    if (!hasValidStoredSize(file, file.local_file_header.get_compression_method())) {
+        return false;
+    }
+
+    const auto *fileData = reader.view(file.compressed_size);
+    ENSURE_READ(fileData != nullptr, "Failed to read file data");
+    file.file_data = std::span(fileData, file.compressed_size);
+
+    if (file.local_file_header.general_purpose_bit_flag.is_data_descriptor_present) {
+        ENSURE_READ(reader.read(&file.data_descriptor, file.data_descriptor.get_struct_size()),
+                    "Failed to read data descriptor");
+
+        if (file.data_descriptor.data_descriptor_signature != 0x08074b50) {
+            std::cerr << "Signature of data descriptor is not 0x08074b50" << std::endl;
+            return false;
+        }
+    }
+
+    file.is_loaded = true;
+    return true;
+}
+
+std::optional<Container> open(std::shared_ptr<const char> data, uint64_t size) {
+    auto reader = Reader{data.get(), size};
+    uint64_t endOfCentralDirectoryRecordPosition = 0;
+    auto endOfCentralDirectoryRecordOpt = readEndOfCentralDirectoryRecord(reader, endOfCentralDirectoryRecordPosition);
     if (!endOfCentralDirectoryRecordOpt.has_value()) {
         return {};
     }
+    auto zip64EndOfCentralDirectoryRecordOpt =
+          readZip64EndOfCentralDirectoryRecord(reader, endOfCentralDirectoryRecordPosition);
+    if (!zip64EndOfCentralDirectoryRecordOpt.has_value()) {
+        return {};
+    }
 
     Container result = {};
+    result.data = std::move(data);
+    result.size = size;
     result.end_of_central_directory_record = endOfCentralDirectoryRecordOpt.value();
+    result.zip64_end_of_central_directory_record = zip64EndOfCentralDirectoryRecordOpt.value();
+
+    // the zip64 record replaces the end of central directory record, whose fields might not be large enough
+    const auto &record = result.end_of_central_directory_record;
+    const auto &zip64Record = result.zip64_end_of_central_directory_record;
+    const auto isZip64 = zip64Record.zip64_end_of_central_directory_signature == 0x06064b50;
+    const auto isSingleDisk =
+          isZip64 ? zip64Record.number_of_the_disk_with_the_start_of_the_central_directory ==
+                          zip64Record.number_of_this_disk
+                  : record.number_of_the_disk_with_the_start_if_the_central_directory == record.number_of_this_disk;
+    if (!isSingleDisk) {
+        std::cerr << "Multiple disks are not supported" << std::endl;
+        return {};
+    }
+    const uint64_t centralDirectoryOffset =
+          isZip64 ? zip64Record.offset_of_start_of_central_directory_with_respect_to_the_starting_disk_number
+                  : record.offset_of_start_of_central_directory_with_respect_to_the_starting_disk_number;
+    const uint64_t entryCount = isZip64 ? zip64Record.total_number_of_entries_in_the_central_directory_on_this_disk
+                                        : record.total_number_of_entries_in_the_central_directory_on_this_disk;
 
-    auto centralDirectoryOpt = readCentralDirectory(fs, result.end_of_central_directory_record);
+    auto centralDirectoryOpt = readCentralDirectory(reader, centralDirectoryOffset, entryCount);
     if (!centralDirectoryOpt.has_value()) {
         return {};
     }
     result.central_directory = centralDirectoryOpt.value();
 
+    // only the central directory is read, the files are loaded when their content is asked for
+    const auto archive = std::span(result.data.get(), size);
+    result.files.reserve(result.central_directory.file_headers.size());
+    result.file_indices.reserve(result.central_directory.file_headers.size());
     for (const auto &central_file_header : result.central_directory.file_headers) {
-        auto fileOpt = readFile(fs, central_file_header);
+        auto fileOpt = createFile(central_file_header, archive);
         if (!fileOpt.has_value()) {
-            std::cerr << "Failed to load file " << central_file_header.get_file_name() << std::endl;
             return {};
         }
+        result.file_indices.insert_or_assign(central_file_header.get_file_name(), result.files.size());
+        result.files.push_back(std::move(fileOpt.value()));
+    }
 
-        result.files.push_back(fileOpt.value());
+    return result;
+}
+
+/*
+ * Maps the whole file read-only. Pages are only loaded when they are touched,
+ * so opening an archive does not read the file data, and stored files are never copied.
+ */
+#ifdef _WIN32
 
-        // fixing up local file header with information from the central file header
-        result.files.back().local_file_header.compressed_size = central_file_header.compressed_size;
-        result.files.back().local_file_header.uncompressed_size = central_file_header.uncompressed_size;
+std::shared_ptr<const char> mapFile(const std::string &filepath, uint64_t &size) {
+    auto *file = CreateFileA(filepath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                             FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open zip file for reading: " << filepath << std::endl;
+        return nullptr;
     }
 
-    return result;
+    LARGE_INTEGER fileSize = {};
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        std::cerr << "Failed to get size of zip file or zip file is empty: " << filepath << std::endl;
+        CloseHandle(file);
+        return nullptr;
+    }
+
+    // the view keeps its own references to the mapping and the file
+    auto *mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        std::cerr << "Failed to create mapping of zip file: " << filepath << std::endl;
+        return nullptr;
+    }
+    const auto *view = static_cast<const char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+    CloseHandle(mapping);
+    if (view == nullptr) {
+        std::cerr << "Failed to map zip file: " << filepath << std::endl;
+        return nullptr;
+    }
+
+    size = static_cast<uint64_t>(fileSize.QuadPart);
+    return std::shared_ptr<const char>(view, [](const char *p) { UnmapViewOfFile(p); });
 }
 
-std::optional<Container> Container::open_from_file(const std::string &filepath) {
-    auto fs = std::ifstream(filepath, std::ios::in | std::ios::binary);
-    if (!fs.is_open()) {
+#else
+
+std::shared_ptr<const char> mapFile(const std::string &filepath, uint64_t &size) {
+    int fd = ::open(filepath.c_str(), O_RDONLY);
+    if (fd < 0) {
         std::cerr << "Failed to open zip file for reading: " << filepath << std::endl;
+        return nullptr;
+    }
+
+    struct stat fileStat = {};
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+        std::cerr << "Failed to get size of zip file or zip file is empty: " << filepath << std::endl;
+        close(fd);
+        return nullptr;
+    }
+
+    const auto mappedSize = static_cast<size_t>(fileStat.st_size);
+    void *mapping = mmap(nullptr, mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    // the mapping keeps its own reference to the file
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "Failed to map zip file: " << filepath << std::endl;
+        return nullptr;
+    }
+
+    size = mappedSize;
+    return std::shared_ptr<const char>(static_cast<const char *>(mapping),
+                                       [mappedSize](const char *p) { munmap(const_cast<char *>(p), mappedSize); });
+}
+
+#endif
+
+/*
+ * A file that is written at explicit offsets, so that nothing has to be written in order.
+ * It is created with the size it is expected to have, which lets the file system allocate it in one piece,
+ * writes past that size grow it.
+ */
+class OutputFile {
+  public:
+    OutputFile() = default;
+    OutputFile(const OutputFile &) = delete;
+    OutputFile &operator=(const OutputFile &) = delete;
+    ~OutputFile();
+
+    bool open(const std::string &filepath, uint64_t size);
+    bool write(uint64_t offset, const char *data, uint64_t count);
+
+  private:
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+};
+
+#ifdef _WIN32
+
+OutputFile::~OutputFile() {
+    if (handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(handle);
+    }
+}
+
+bool OutputFile::open(const std::string &filepath, uint64_t size) {
+    handle = CreateFileA(filepath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle == INVALID_HANDLE_VALUE) {
+        std::cerr << "Failed to open file for writing: " << filepath << std::endl;
+        return false;
+    }
+
+    LARGE_INTEGER end = {};
+    end.QuadPart = static_cast<LONGLONG>(size);
+    if (!SetFilePointerEx(handle, end, nullptr, FILE_BEGIN) || !SetEndOfFile(handle)) {
+        std::cerr << "Failed to allocate " << size << " bytes for file: " << filepath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool OutputFile::write(uint64_t offset, const char *data, uint64_t count) {
+    while (count > 0) {
+        // the offset of a synchronous write is passed in the overlapped structure
+        OVERLAPPED overlapped = {};
+        overlapped.Offset = static_cast<DWORD>(offset);
+        overlapped.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        const auto chunkSize = static_cast<DWORD>(std::min<uint64_t>(count, 1U << 30));
+        DWORD written = 0;
+        if (!WriteFile(handle, data, chunkSize, &written, &overlapped) || written == 0) {
+            std::cerr << "Failed to write file" << std::endl;
+            return false;
+        }
+        offset += written;
+        data += written;
+        count -= written;
+    }
+    return true;
+}
+
+#else
+
+OutputFile::~OutputFile() {
+    if (fd >= 0) {
+        close(fd);
+    }
+}
+
+bool OutputFile::open(const std::string &filepath, uint64_t size) {
+    fd = ::open(filepath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        std::cerr << "Failed to open file for writing: " << filepath << std::endl;
+        return false;
+    }
+    if (size == 0) {
+        return true;
+    }
+
+#ifdef __linux__
+    // not every file system can allocate, truncating at least sets the size
+    if (posix_fallocate(fd, 0, static_cast<off_t>(size)) == 0) {
+        return true;
+    }
+#endif
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+        std::cerr << "Failed to allocate " << size << " bytes for file: " << filepath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool OutputFile::write(uint64_t offset, const char *data, uint64_t count) {
+    while (count > 0) {
+        const auto written = pwrite(fd, data, count, static_cast<off_t>(offset));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            std::cerr << "Failed to write file: " << std::strerror(errno) << std::endl;
+            return false;
+        }
+        offset += written;
+        data += written;
+        count -= written;
+    }
+    return true;
+}
+
+#endif
+
+/*
+ * Extracts files one after another. The content reader is reused for all of them,
+ * so that a thread does not allocate anything per file, apart from opening the output file.
+ */
+bool extractFile(ContentReader &reader, File &file, const std::string &filepath) {
+    auto output = OutputFile();
+    // the uncompressed size is not checked yet, a broken or malicious archive must not be able to fill the disk
+    if (!output.open(filepath, getReservedSize(file))) {
+        return false;
+    }
+
+    uint64_t offset = 0;
+    return reader.read(file, [&output, &offset](std::string_view chunk) {
+        const auto success = output.write(offset, chunk.data(), chunk.size());
+        offset += chunk.size();
+        return success;
+    });
+}
+
+std::optional<Container> Container::open_from_file(const std::string &filepath) {
+    uint64_t size = 0;
+    auto data = mapFile(filepath, size);
+    if (data == nullptr) {
         return {};
     }
 
-    return open(fs);
+    return open(std::move(data), size);
+}
+
+std::optional<Container> Container::open_from_memory(const char *data, uint64_t size) {
+    // the memory belongs to the caller
+    return open(std::shared_ptr<const char>(data, [](const char *) {}), size);
 }
 
-std::optional<Container> Container::open_from_memory(char *data, uint64_t size) {
-    auto s = std::string(data, size);
-    auto ss = std::stringstream(s, std::ios::in | std::ios::binary);
-    return open(ss);
+File *Container::find(std::string_view name) {
+    const auto itr = file_indices.find(name);
+    if (itr == file_indices.end()) {
+        return nullptr;
+    }
+    return &files[itr->second];
 }
 
 std::optional<std::string_view> File::get_content() {
+    if (!is_loaded && !loadFile(*this)) {
+        std::cerr << "Failed to load file " << get_file_name() << std::endl;
+        return {};
+    }
+
     auto compressionMethod = local_file_header.get_compression_method();
     if (compressionMethod == CompressionMethod::NO_COMPRESSION) {
-        return std::string_view(file_data, local_file_header.uncompressed_size);
+        return std::string_view(file_data.data(), uncompressed_size);
     }
 
     if (compressionMethod != CompressionMethod::DEFLATED) {
@@ -219,57 +639,160 @@ std::optional<std::string_view> File::get_content() {
         return {};
     }
 
-    if (uncompressed_file_data != nullptr) {
-        return std::string_view(uncompressed_file_data, local_file_header.uncompressed_size);
+    if (!uncompressed_file_data.empty() || uncompressed_size == 0) {
+        return std::string_view(uncompressed_file_data.data(), uncompressed_file_data.size());
     }
 
-    auto *input = file_data;
-    size_t inputSize = local_file_header.compressed_size;
+    // the content is inflated chunk by chunk, because a single call can not fill more than 4 GiB
+    auto output = std::vector<char>();
+    output.reserve(getReservedSize(*this));
+    auto reader = ContentReader();
+    const auto success = reader.read(*this, [&output](std::string_view chunk) {
+        output.insert(output.end(), chunk.begin(), chunk.end());
+        return true;
+    });
+    if (!success) {
+        return {};
+    }
 
-    auto *output = (char *)malloc(local_file_header.uncompressed_size);
-    size_t outputSize = local_file_header.uncompressed_size;
+    uncompressed_file_data = std::move(output);
+    return std::string_view(uncompressed_file_data.data(), uncompressed_file_data.size());
+}
 
-    z_stream infstream;
-    infstream.zalloc = Z_NULL;
-    infstream.zfree = Z_NULL;
-    infstream.opaque = Z_NULL;
-    infstream.avail_in = (uInt)inputSize;   // size of input
-    infstream.next_in = (Bytef *)input;     // input char array
-    infstream.avail_out = (uInt)outputSize; // size of output
-    infstream.next_out = (Bytef *)output;   // output char array
+bool File::read_content(const std::function<bool(std::string_view chunk)> &onChunk) {
+    auto reader = ContentReader();
+    return reader.read(*this, onChunk);
+}
 
-    auto err = inflateInit2(&infstream, -MAX_WBITS);
-    if (err < 0) {
-        std::cerr << "Failed to inflate file data: " << infstream.msg << std::endl;
-        return {};
+struct ContentReader::InflateState {
+    z_stream stream = {};
+    bool isInitialized = false;
+
+    ~InflateState() {
+        if (isInitialized) {
+            inflateEnd(&stream);
+        }
     }
+};
 
-    err = inflate(&infstream, Z_NO_FLUSH);
-    if (err < 0) {
-        std::cerr << "Failed to inflate file data: " << infstream.msg << std::endl;
-        return {};
+ContentReader::ContentReader(size_t bufferSize)
+    : state(std::make_unique<InflateState>()), buffer(std::max<size_t>(bufferSize, 1)) {}
+
+ContentReader::~ContentReader() = default;
+
+bool ContentReader::read(File &file, const std::function<bool(std::string_view chunk)> &onChunk) {
+    if (!file.is_loaded && !loadFile(file)) {
+        std::cerr << "Failed to load file " << file.get_file_name() << std::endl;
+        return false;
     }
 
-    if (infstream.avail_out != 0) {
-        std::cerr << "Failed to inflate file data in a single call" << std::endl;
-        return {};
+    const auto uncompressedSize = file.uncompressed_size;
+    const auto compressionMethod = file.local_file_header.get_compression_method();
+    if (compressionMethod == CompressionMethod::NO_COMPRESSION) {
+        // stored files are passed on in place, in chunks of the same size as inflated ones
+        for (uint64_t offset = 0; offset < uncompressedSize; offset += buffer.size()) {
+            const auto count = std::min<uint64_t>(buffer.size(), uncompressedSize - offset);
+            if (!onChunk(std::string_view(file.file_data.data() + offset, count))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    if (compressionMethod != CompressionMethod::DEFLATED) {
+        std::cerr << "Compression methods other than DEFLATED are not supported" << std::endl;
+        return false;
+    }
+    if (uncompressedSize == 0) {
+        return true;
+    }
+
+    auto &stream = state->stream;
+    auto err = state->isInitialized ? inflateReset(&stream) : inflateInit2(&stream, -MAX_WBITS);
+    if (err != Z_OK) {
+        std::cerr << "Failed to inflate file data: " << (stream.msg != nullptr ? stream.msg : "") << std::endl;
+        return false;
+    }
+    state->isInitialized = true;
+
+    // avail_in is only 32 bits wide, larger files are passed in several pieces
+    const auto *input = file.file_data.data();
+    auto remainingInput = static_cast<uint64_t>(file.file_data.size());
+    stream.avail_in = 0;
+    uint64_t outputSize = 0;
+    while (err != Z_STREAM_END) {
+        if (stream.avail_in == 0 && remainingInput > 0) {
+            stream.next_in = (Bytef *)input;
+            stream.avail_in = (uInt)std::min<uint64_t>(remainingInput, std::numeric_limits<uInt>::max());
+            input += stream.avail_in;
+            remainingInput -= stream.avail_in;
+        }
+        stream.next_out = (Bytef *)buffer.data();
+        stream.avail_out = (uInt)buffer.size();
+
+        err = inflate(&stream, Z_NO_FLUSH);
+        if (err != Z_OK && err != Z_STREAM_END) {
+            std::cerr << "Failed to inflate " << file.get_file_name() << ": "
+                      << (stream.msg != nullptr ? stream.msg : "file data is truncated") << std::endl;
+            return false;
+        }
+
+        const auto count = buffer.size() - stream.avail_out;
+        outputSize += count;
+        if (outputSize > uncompressedSize) {
+            std::cerr << "Inflated " << file.get_file_name() << " is larger than " << uncompressedSize << " bytes"
+                      << std::endl;
+            return false;
+        }
+        if (count > 0 && !onChunk(std::string_view(buffer.data(), count))) {
+            return false;
+        }
     }
 
-    err = inflateEnd(&infstream);
-    if (err < 0) {
-        std::cerr << "Failed to inflate file data: " << infstream.msg << std::endl;
+    if (outputSize != uncompressedSize) {
+        std::cerr << "Inflated " << file.get_file_name() << " has " << outputSize << " instead of "
+                  << uncompressedSize << " bytes" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/*
+ * The path of the file in the directory, or nothing if its name would put it outside of the directory.
+ * Absolute names replace the directory when they are appended to it, ".." leaves it.
+ */
+std::optional<std::filesystem::path> getDestinationPath(const std::filesystem::path &root, std::string_view name) {
+    const auto path = std::filesystem::path(name);
+    if (path.is_absolute() || path.has_root_name() || path.has_root_directory()) {
+        std::cerr << "Refusing to extract file with absolute path " << name << std::endl;
         return {};
     }
+    for (const auto &component : path) {
+        if (component == "..") {
+            std::cerr << "Refusing to extract file with .. in its path " << name << std::endl;
+            return {};
+        }
+    }
 
-    uncompressed_file_data = output;
-    return std::string_view(uncompressed_file_data, local_file_header.uncompressed_size);
+    const auto normalRoot = root.lexically_normal();
+    auto result = (normalRoot / path).lexically_normal();
+    const auto relativePath = result.lexically_relative(normalRoot);
+    if (relativePath.empty() || *relativePath.begin() == "..") {
+        std::cerr << "Refusing to extract file outside of the directory " << name << std::endl;
+        return {};
+    }
+    return result;
 }
 
 void Container::extract_to_directory(const std::string &directoryPath) {
     std::filesystem::create_directories(directoryPath);
 
     for (auto &file : files) {
-        const auto destinationFilepath = directoryPath + "/" + std::string(file.get_file_name());
+        const auto destinationPathOpt = getDestinationPath(directoryPath, file.get_file_name());
+        if (!destinationPathOpt) {
+            return;
+        }
+        const auto destinationFilepath = destinationPathOpt->string();
         auto os = std::ofstream(destinationFilepath, std::ios::out | std::ios::binary | std::ios::trunc);
 
         auto contentOpt = file.get_content();
@@ -283,4 +806,99 @@ void Container::extract_to_directory(const std::string &directoryPath) {
     }
 }
 
+std::optional<ExtractionReport> Container::extract_to_directory_in_parallel(const std::string &directoryPath,
+                                                                              unsigned int threadCount) {
+    const auto start = std::chrono::steady_clock::now();
+
+    const auto root = std::filesystem::path(directoryPath);
+    // checking all names before anything is written
+    auto destinationPaths = std::vector<std::filesystem::path>();
+    destinationPaths.reserve(files.size());
+    for (const auto &file : files) {
+        auto destinationPathOpt = getDestinationPath(root, file.get_file_name());
+        if (!destinationPathOpt) {
+            return {};
+        }
+        destinationPaths.push_back(std::move(destinationPathOpt.value()));
+    }
+
+    // creating the directories up front, so that the threads do not race each other creating the same ones
+    std::error_code error = {};
+    std::filesystem::create_directories(root, error);
+    if (error) {
+        std::cerr << "Failed to create directory " << directoryPath << ": " << error.message() << std::endl;
+        return {};
+    }
+
+    auto filepaths = std::vector<std::string>(files.size());
+    auto fileIndices = std::vector<size_t>();
+    fileIndices.reserve(files.size());
+    for (size_t i = 0; i < files.size(); i++) {
+        const auto name = files[i].get_file_name();
+        const auto &filepath = destinationPaths[i];
+        const auto isDirectory = !name.empty() && name.back() == '/';
+        std::filesystem::create_directories(isDirectory ? filepath : filepath.parent_path(), error);
+        if (error) {
+            std::cerr << "Failed to create directory for " << name << ": " << error.message() << std::endl;
+            return {};
+        }
+        if (!isDirectory) {
+            filepaths[i] = filepath.string();
+            fileIndices.push_back(i);
+        }
+    }
+
+    // the largest files go first, so that no thread is left with a large file at the end
+    std::sort(fileIndices.begin(), fileIndices.end(), [this](size_t a, size_t b) {
+        return files[a].compressed_size > files[b].compressed_size;
+    });
+
+    if (threadCount == 0) {
+        threadCount = std::max(1U, std::thread::hardware_concurrency());
+    }
+#ifdef __EMSCRIPTEN__
+    // threads are not available without building for pthreads
+    threadCount = 1;
+#endif
+    threadCount = std::max(1U, std::min<unsigned int>(threadCount, fileIndices.size()));
+
+    std::atomic<size_t> nextIndex = 0;
+    std::atomic<bool> hasFailed = false;
+    auto work = [&]() {
+        auto reader = ContentReader();
+        for (auto i = nextIndex++; i < fileIndices.size() && !hasFailed; i = nextIndex++) {
+            const auto fileIndex = fileIndices[i];
+            if (!extractFile(reader, files[fileIndex], filepaths[fileIndex])) {
+                hasFailed = true;
+            }
+        }
+    };
+
+    // the calling thread is part of the pool
+    auto threads = std::vector<std::thread>();
+    threads.reserve(threadCount - 1);
+    for (unsigned int i = 1; i < threadCount; i++) {
+        threads.emplace_back(work);
+    }
+    work();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    if (hasFailed) {
+        std::cerr << "Failed to extract zip archive to " << directoryPath << std::endl;
+        return {};
+    }
+
+    auto report = ExtractionReport();
+    report.file_count = fileIndices.size();
+    for (const auto fileIndex : fileIndices) {
+        report.compressed_bytes += files[fileIndex].compressed_size;
+        report.uncompressed_bytes += files[fileIndex].uncompressed_size;
+    }
+    report.thread_count = threadCount;
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
 } // namespace zip
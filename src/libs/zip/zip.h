@@ -1,9 +1,13 @@
 #pragma once
 
 #include <cstdint>
+#include <functional>
+#include <memory>
 #include <optional>
+#include <span>
 #include <string>
 #include <string_view>
+#include <unordered_map>
 #include <vector>
 
 namespace zip {
@@ -71,8 +75,8 @@ struct LocalFileHeader {
     uint16_t file_name_length = 0;
     uint16_t extra_field_length = 0;
 
-    char *file_name = nullptr;
-    char *extra_field = nullptr;
+    const char *file_name = nullptr;
+    const char *extra_field = nullptr;
 
     uint64_t get_struct_size() {
         auto result = sizeof(*this);
@@ -133,9 +137,9 @@ struct CentralFileHeader {
     uint32_t external_file_attributes = 0;
     uint32_t relative_offset_of_local_header = 0;
 
-    char *file_name = nullptr;
-    char *extra_field = nullptr;
-    char *file_comment = nullptr;
+    const char *file_name = nullptr;
+    const char *extra_field = nullptr;
+    const char *file_comment = nullptr;
 
     uint64_t get_struct_size() {
         auto result = sizeof(*this);
@@ -155,7 +159,7 @@ struct CentralDirectorySignature {
     uint32_t header_signature = 0;
     uint16_t size_of_data = 0;
 
-    char *signature_data = nullptr;
+    const char *signature_data = nullptr;
 
     uint64_t get_struct_size() {
         auto result = sizeof(*this);
@@ -189,21 +193,118 @@ struct EndOfCentralDirectoryRecord {
     uint32_t offset_of_start_of_central_directory_with_respect_to_the_starting_disk_number = 0;
     uint16_t zip_file_comment_length = 0;
 
-    char *zip_file_comment = nullptr;
+    const char *zip_file_comment = nullptr;
 
     uint64_t get_struct_size() { return sizeof(*this) - sizeof(zip_file_comment); }
 };
+
+struct Zip64EndOfCentralDirectoryLocator {
+    // zip64 end of central dir locator
+    // signature                       4 bytes  (0x07064b50)
+    // number of the disk with the
+    // start of the zip64 end of
+    // central directory               4 bytes
+    // relative offset of the zip64
+    // end of central directory record 8 bytes
+    // total number of disks           4 bytes
+
+    uint32_t zip64_end_of_central_directory_locator_signature = 0;
+    uint32_t number_of_the_disk_with_the_start_of_the_zip64_end_of_central_directory = 0;
+    uint64_t relative_offset_of_the_zip64_end_of_central_directory_record = 0;
+    uint32_t total_number_of_disks = 0;
+
+    uint64_t get_struct_size() { return sizeof(*this); }
+};
+
+struct Zip64EndOfCentralDirectoryRecord {
+    // zip64 end of central dir
+    // signature                       4 bytes  (0x06064b50)
+    // size of zip64 end of central
+    // directory record                8 bytes
+    // version made by                 2 bytes
+    // version needed to extract       2 bytes
+    // number of this disk             4 bytes
+    // number of the disk with the
+    // start of the central directory  4 bytes
+    // total number of entries in the
+    // central directory on this disk  8 bytes
+    // total number of entries in the
+    // central directory               8 bytes
+    // size of the central directory   8 bytes
+    // offset of start of central
+    // directory with respect to
+    // the starting disk number        8 bytes
+    // zip64 extensible data sector    (variable size)
+
+    uint32_t zip64_end_of_central_directory_signature = 0;
+    uint64_t size_of_zip64_end_of_central_directory_record = 0;
+    uint16_t version_made_by = 0;
+    uint16_t version_needed_to_extract = 0;
+    uint32_t number_of_this_disk = 0;
+    uint32_t number_of_the_disk_with_the_start_of_the_central_directory = 0;
+    uint64_t total_number_of_entries_in_the_central_directory_on_this_disk = 0;
+    uint64_t total_number_of_entries_in_the_central_directory = 0;
+    uint64_t size_of_the_central_directory = 0;
+    uint64_t offset_of_start_of_central_directory_with_respect_to_the_starting_disk_number = 0;
+
+    uint64_t get_struct_size() { return sizeof(*this); }
+};
 #pragma pack(pop)
 
+/*
+ * The variable size fields of the headers (file names, extra fields, comments) and the file data are not copied,
+ * they point into the archive the Container was opened from.
+ */
+
 struct File {
+    // opening an archive only fills in what the central file header knows about the file,
+    // the local file header, the file data and the data descriptor are read when the content is asked for
     LocalFileHeader local_file_header = {};
-    char *file_data = nullptr;
+    std::span<const char> file_data = {};
+    // the sizes in the data descriptor of a zip64 file are 8 bytes wide, only its signature and crc-32 are valid
     DataDescriptor data_descriptor = {};
+    bool is_loaded = false;
+
+    // the sizes from the central file header, or from its zip64 extended information if they do not fit in 4 bytes,
+    // the sizes in the local file header are only valid if they fit
+    uint64_t compressed_size = 0;
+    uint64_t uncompressed_size = 0;
+
+    // only filled for compressed files, once their content is asked for
+    std::vector<char> uncompressed_file_data = {};
 
-    char *uncompressed_file_data = nullptr;
+    std::span<const char> archive = {};
+    uint64_t local_file_header_offset = 0;
 
     std::string_view get_file_name() const { return local_file_header.get_file_name(); }
     std::optional<std::string_view> get_content();
+
+    // reads the content in chunks without keeping it, see ContentReader
+    bool read_content(const std::function<bool(std::string_view chunk)> &onChunk);
+};
+
+/**
+ * Reads the content of files in chunks of at most bufferSize bytes, so that files of any size take the same memory.
+ * Compressed files are inflated into the buffer, stored files are passed on in place.
+ * The buffer and the inflate state are reused for all files read with the same reader.
+ */
+class ContentReader {
+  public:
+    explicit ContentReader(size_t bufferSize = 256 * 1024);
+    ContentReader(const ContentReader &) = delete;
+    ContentReader &operator=(const ContentReader &) = delete;
+    ~ContentReader();
+
+    /**
+     * Calls onChunk with the content of the file chunk by chunk, in order.
+     * A chunk is only valid until onChunk returns. Reading stops and fails when onChunk returns false.
+     */
+    bool read(File &file, const std::function<bool(std::string_view chunk)> &onChunk);
+
+  private:
+    struct InflateState;
+    std::unique_ptr<InflateState> state;
+    std::vector<char> buffer;
 };
 
 struct CentralDirectory {
@@ -211,15 +312,51 @@ struct CentralDirectory {
     CentralDirectorySignature digital_signature = {};
 };
 
+struct ExtractionReport {
+    size_t file_count = 0;
+    uint64_t compressed_bytes = 0;
+    uint64_t uncompressed_bytes = 0;
+    unsigned int thread_count = 0;
+    double seconds = 0.0;
+
+    // uncompressed megabytes written per second, over all threads
+    double get_throughput() const {
+        return seconds > 0.0 ? static_cast<double>(uncompressed_bytes) / 1e6 / seconds : 0.0;
+    }
+};
+
 struct Container {
+    // the archive all files and headers point into, either a read-only memory mapping of the archive file,
+    // or the memory passed to open_from_memory, which is not owned and has to outlive the container
+    std::shared_ptr<const char> data = nullptr;
+    uint64_t size = 0;
+
     std::vector<File> files = {};
+    // index into files by file name, if a name is in the archive more than once, the last file wins
+    std::unordered_map<std::string_view, size_t> file_indices = {};
     CentralDirectory central_directory = {};
     EndOfCentralDirectoryRecord end_of_central_directory_record = {};
+    // only present in archives with more than 65535 files or more than 4 GiB, the signature is 0 otherwise
+    Zip64EndOfCentralDirectoryRecord zip64_end_of_central_directory_record = {};
+
+    // the file with the name, or nullptr if there is none
+    File *find(std::string_view name);
 
     void extract_to_directory(const std::string &directoryPath);
 
+    /**
+     * Extracts the files with a pool of threadCount threads, or one per core if threadCount is 0.
+     * Every thread takes the next file, largest first, and reads it with its own ContentReader
+     * into positioned writes of an output file that was preallocated to the uncompressed size,
+     * but to no more than 16 times the compressed size, because the uncompressed size is not checked before.
+     * Names ending in '/' are directories, the directories of all files are created up front.
+     * The content of the files is not kept, unlike with get_content().
+     */
+    std::optional<ExtractionReport> extract_to_directory_in_parallel(const std::string &directoryPath,
+                                                                     unsigned int threadCount = 0);
+
     static std::optional<Container> open_from_file(const std::string &filepath);
-    static std::optional<Container> open_from_memory(char *data, uint64_t size);
+    static std::optional<Container> open_from_memory(const char *data, uint64_t size);
 };
 
 } // namespace zip
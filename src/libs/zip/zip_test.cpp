@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 
+#include <cstring>
 #include <filesystem>
+#include <fstream>
 #include <zip.h>
 
 TEST(zip, opens_test_zip) {
@@ -16,3 +18,215 @@ TEST(zip, opens_test_zip) {
     ASSERT_TRUE(contentOpt.has_value());
     ASSERT_EQ("This is a test file", contentOpt.value());
 }
+
+TEST(zip, reads_stored_files_in_place) {
+    auto zOpt = zip::Container::open_from_file("zip_test_resources/resources/stored.zip");
+    ASSERT_TRUE(zOpt.has_value());
+
+    auto z = zOpt.value();
+    ASSERT_EQ(2, z.files.size());
+    ASSERT_EQ("stored test archive", std::string_view(z.end_of_central_directory_record.zip_file_comment,
+                                                      z.end_of_central_directory_record.zip_file_comment_length));
+
+    // stored files are not copied, their content points into the mapping of the archive
+    const auto *begin = z.data.get();
+    const auto *end = begin + z.size;
+    for (auto &file : z.files) {
+        auto contentOpt = file.get_content();
+        ASSERT_TRUE(contentOpt.has_value());
+        ASSERT_GE(contentOpt->data(), begin);
+        ASSERT_LE(contentOpt->data() + contentOpt->size(), end);
+        ASSERT_GE(file.get_file_name().data(), begin);
+        ASSERT_LE(file.get_file_name().data() + file.get_file_name().size(), end);
+    }
+    ASSERT_EQ("This is a test file", z.files[0].get_content().value());
+    ASSERT_EQ("This is another test file", z.files[1].get_content().value());
+}
+
+TEST(zip, opens_zip_in_memory_without_copying) {
+    auto is = std::ifstream("zip_test_resources/resources/test.zip", std::ios::in | std::ios::binary);
+    auto data = std::vector<char>(std::istreambuf_iterator<char>(is), {});
+    ASSERT_FALSE(data.empty());
+
+    auto zOpt = zip::Container::open_from_memory(data.data(), data.size());
+    ASSERT_TRUE(zOpt.has_value());
+    ASSERT_EQ(data.data(), zOpt->data.get());
+    ASSERT_EQ(2, zOpt->files.size());
+    ASSERT_GE(zOpt->files[0].get_file_name().data(), data.data());
+    ASSERT_LT(zOpt->files[0].get_file_name().data(), data.data() + data.size());
+    ASSERT_EQ("This is a test file", zOpt->files[0].get_content().value());
+
+    // truncated archives are rejected instead of being read past their end
+    ASSERT_FALSE(zip::Container::open_from_memory(data.data(), data.size() - 30).has_value());
+    ASSERT_FALSE(zip::Container::open_from_memory(data.data(), 10).has_value());
+}
+
+TEST(zip, finds_files_by_name_and_loads_them_lazily) {
+    auto zOpt = zip::Container::open_from_file("zip_test_resources/resources/test.zip");
+    ASSERT_TRUE(zOpt.has_value());
+
+    auto z = zOpt.value();
+    ASSERT_EQ(nullptr, z.find("missing.txt"));
+    auto *file = z.find("world.txt");
+    ASSERT_EQ(&z.files[1], file);
+
+    // opening only reads the central directory, the local file header is read with the content
+    ASSERT_FALSE(file->is_loaded);
+    ASSERT_EQ(25, file->local_file_header.uncompressed_size);
+    ASSERT_EQ("This is another test file", file->get_content().value());
+    ASSERT_TRUE(file->is_loaded);
+    ASSERT_EQ(0x04034b50, file->local_file_header.local_file_header_signature);
+    ASSERT_EQ(25, file->local_file_header.uncompressed_size);
+    ASSERT_FALSE(z.files[0].is_loaded);
+}
+
+TEST(zip, extracts_files_in_parallel) {
+    const auto directory = std::filesystem::temp_directory_path() / "zip_test_extracts_files_in_parallel";
+    std::filesystem::remove_all(directory);
+
+    for (const auto *archive : {"test.zip", "stored.zip"}) {
+        auto zOpt = zip::Container::open_from_file(std::string("zip_test_resources/resources/") + archive);
+        ASSERT_TRUE(zOpt.has_value());
+
+        auto reportOpt = zOpt->extract_to_directory_in_parallel(directory.string(), 2);
+        ASSERT_TRUE(reportOpt.has_value());
+        ASSERT_EQ(2, reportOpt->file_count);
+        ASSERT_EQ(2, reportOpt->thread_count);
+        ASSERT_EQ(44, reportOpt->uncompressed_bytes);
+
+        auto read = [&directory](const char *name) {
+            auto is = std::ifstream(directory / name, std::ios::in | std::ios::binary);
+            return std::string(std::istreambuf_iterator<char>(is), {});
+        };
+        ASSERT_EQ("This is a test file", read("hello.txt"));
+        ASSERT_EQ("This is another test file", read("world.txt"));
+    }
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(zip, reads_content_in_chunks) {
+    auto is = std::ifstream("zip_test_resources/resources/reference.txt", std::ios::in | std::ios::binary);
+    const auto expected = std::string(std::istreambuf_iterator<char>(is), {});
+    ASSERT_FALSE(expected.empty());
+
+    auto zOpt = zip::Container::open_from_file("zip_test_resources/resources/reference.zip");
+    ASSERT_TRUE(zOpt.has_value());
+    auto *file = zOpt->find("reference.txt");
+    ASSERT_NE(nullptr, file);
+
+    // the buffer is reused for every chunk, so no chunk is larger than it
+    auto reader = zip::ContentReader(4096);
+    auto content = std::string();
+    size_t chunkCount = 0;
+    ASSERT_TRUE(reader.read(*file, [&](std::string_view chunk) {
+        EXPECT_LE(chunk.size(), 4096);
+        content.append(chunk);
+        chunkCount++;
+        return true;
+    }));
+    ASSERT_EQ(expected, content);
+    ASSERT_GE(chunkCount, expected.size() / 4096);
+    ASSERT_TRUE(file->uncompressed_file_data.empty());
+
+    // stopping early fails, the reader can be used again afterwards
+    ASSERT_FALSE(reader.read(*file, [](std::string_view) { return false; }));
+    ASSERT_EQ(expected, file->get_content().value());
+
+    auto storedOpt = zip::Container::open_from_file("zip_test_resources/resources/stored.zip");
+    ASSERT_TRUE(storedOpt.has_value());
+    content.clear();
+    ASSERT_TRUE(reader.read(storedOpt->files[1], [&](std::string_view chunk) {
+        content.append(chunk);
+        return true;
+    }));
+    ASSERT_EQ("This is another test file", content);
+}
+
+TEST(zip, opens_zip64_archive) {
+    // all sizes, offsets and counts of this archive are only stored in its zip64 structures
+    auto zOpt = zip::Container::open_from_file("zip_test_resources/resources/zip64.zip");
+    ASSERT_TRUE(zOpt.has_value());
+    ASSERT_EQ(0x06064b50, zOpt->zip64_end_of_central_directory_record.zip64_end_of_central_directory_signature);
+    ASSERT_EQ(0xFFFF, zOpt->end_of_central_directory_record.total_number_of_entries_in_the_central_directory);
+    ASSERT_EQ(2, zOpt->files.size());
+
+    auto *file = zOpt->find("world.txt");
+    ASSERT_NE(nullptr, file);
+    ASSERT_EQ(25, file->compressed_size);
+    ASSERT_EQ(25, file->uncompressed_size);
+    ASSERT_EQ(78, file->local_file_header_offset);
+    ASSERT_EQ("This is another test file", file->get_content().value());
+    ASSERT_EQ("This is a test file", zOpt->find("hello.txt")->get_content().value());
+
+    // archives without zip64 structures leave the record empty
+    auto testOpt = zip::Container::open_from_file("zip_test_resources/resources/test.zip");
+    ASSERT_TRUE(testOpt.has_value());
+    ASSERT_EQ(0, testOpt->zip64_end_of_central_directory_record.zip64_end_of_central_directory_signature);
+}
+
+TEST(zip, refuses_to_extract_files_outside_of_the_directory) {
+    const auto directory = std::filesystem::temp_directory_path() / "zip_test_refuses_to_extract";
+    const auto destination = directory / "out";
+    std::filesystem::remove_all(directory);
+    std::filesystem::remove("/tmp/zip_test_absolute_escape.txt");
+
+    // absolute names would replace the directory, ".." would leave it
+    for (const auto *archive : {"absolute.zip", "dotdot.zip"}) {
+        auto zOpt = zip::Container::open_from_file(std::string("zip_test_resources/resources/") + archive);
+        ASSERT_TRUE(zOpt.has_value());
+        ASSERT_FALSE(zOpt->extract_to_directory_in_parallel(destination.string(), 2).has_value());
+    }
+
+    // the names are checked before anything is written
+    ASSERT_FALSE(std::filesystem::exists("/tmp/zip_test_absolute_escape.txt"));
+    ASSERT_FALSE(std::filesystem::exists(directory / "zip_test_dotdot_escape.txt"));
+    ASSERT_FALSE(std::filesystem::exists(destination / "hello.txt"));
+
+    std::filesystem::remove_all(directory);
+}
+
+TEST(zip, rejects_stored_files_larger_than_their_data) {
+    // hello.txt claims to be 50000000 bytes large, but only has 19 bytes of data in the archive
+    auto zOpt = zip::Container::open_from_file("zip_test_resources/resources/stored_size_mismatch.zip");
+    ASSERT_FALSE(zOpt.has_value());
+}
+
+// test.zip, but world.txt claims an uncompressed size of almost 4 GiB in its central file header
+std::vector<char> readTestZipWithLargeUncompressedSize() {
+    auto is = std::ifstream("zip_test_resources/resources/test.zip", std::ios::in | std::ios::binary);
+    auto data = std::vector<char>(std::istreambuf_iterator<char>(is), {});
+    const auto archive = std::string_view(data.data(), data.size());
+    const auto worldOffset = archive.find("PK\x01\x02", archive.find("PK\x01\x02") + 4);
+    if (worldOffset == std::string_view::npos) {
+        return {};
+    }
+    const uint32_t uncompressedSize = 0xFFFFFFFE;
+    std::memcpy(data.data() + worldOffset + 24, &uncompressedSize, sizeof(uncompressedSize));
+    return data;
+}
+
+TEST(zip, does_not_trust_uncompressed_size_for_allocations) {
+    auto data = readTestZipWithLargeUncompressedSize();
+    ASSERT_FALSE(data.empty());
+
+    auto zOpt = zip::Container::open_from_memory(data.data(), data.size());
+    ASSERT_TRUE(zOpt.has_value());
+    ASSERT_EQ(0xFFFFFFFE, zOpt->files[1].uncompressed_size);
+    // the content is inflated before the size is compared, instead of allocating 4 GiB up front
+    ASSERT_FALSE(zOpt->files[1].get_content().has_value());
+    ASSERT_EQ("This is a test file", zOpt->files[0].get_content().value());
+}
+
+TEST(zip, does_not_trust_uncompressed_size_for_preallocation) {
+    auto data = readTestZipWithLargeUncompressedSize();
+    ASSERT_FALSE(data.empty());
+
+    const auto directory = std::filesystem::temp_directory_path() / "zip_test_does_not_trust_uncompressed_size";
+    std::filesystem::remove_all(directory);
+    auto zOpt = zip::Container::open_from_memory(data.data(), data.size());
+    ASSERT_TRUE(zOpt.has_value());
+    ASSERT_FALSE(zOpt->extract_to_directory_in_parallel(directory.string(), 1).has_value());
+    ASSERT_LT(std::filesystem::file_size(directory / "world.txt"), 1024);
+    std::filesystem::remove_all(directory);
+}
@@ -2,6 +2,8 @@
 
 #include <algorithm>
 #include <array>
+#include <cmath>
+#include <limits>
 
 #include "Main.h"
 
@@ -12,6 +14,22 @@ constexpr float Z_FAR = 100000.0F;
 constexpr auto WIDTH = 50;
 constexpr auto LENGTH = 100;
 
+constexpr unsigned int SPECTRUM_WINDOW_SIZE = 1024;
+
+// one bin per column, spaced logarithmically up to half of the window like the pitches of notes
+std::vector<unsigned int> createSpectrumBins() {
+    auto bins = std::vector<unsigned int>();
+    for (int column = 0; column < WIDTH; column++) {
+        const auto t = static_cast<double>(column) / static_cast<double>(WIDTH - 1);
+        auto bin = static_cast<unsigned int>(std::round(std::pow(SPECTRUM_WINDOW_SIZE / 2.0, t)));
+        if (!bins.empty()) {
+            bin = std::max(bin, bins.back() + 1);
+        }
+        bins.push_back(bin);
+    }
+    return bins;
+}
+
 DEFINE_SCENE_MAIN(AudioVis)
 DEFINE_DEFAULT_SHADERS(audio_vis_AudioVis)
 
@@ -28,6 +46,8 @@ void AudioVis::setup() {
         inputData[i] = static_cast<float>(wav.data.data8[i]);
     }
     playBack.coefficients = fourier::fft(inputData, playBack.wav->header.sampleRate);
+    slidingDft = std::make_shared<fourier::SlidingDft>(SPECTRUM_WINDOW_SIZE, createSpectrumBins());
+    spectrumLines = std::vector<float>(WIDTH * LENGTH, 0.0F);
 
     initSoundIo(wav.header.sampleRate);
     initMesh();
@@ -87,7 +107,7 @@ void AudioVis::tick() {
 
     ImGui::DragInt("Lines Per Second", &linesPerSecond, 1, 1, wav.header.sampleRate);
 
-    std::array<const char *, 4> items = {"AMPLITUDE", "PHASE", "FREQUENCY", "MAGNITUDE"};
+    std::array<const char *, 5> items = {"AMPLITUDE", "PHASE", "FREQUENCY", "MAGNITUDE", "SPECTRUM"};
     ImGui::Combo("Current Mode", reinterpret_cast<int *>(&currentMode),
                  reinterpret_cast<const char *const *>(items.data()), items.size());
 
@@ -107,6 +127,9 @@ void AudioVis::tick() {
     case VisMode::MAGNITUDE:
         updateMeshMagnitude(linesPerSecond);
         break;
+    case VisMode::SPECTRUM:
+        updateMeshSpectrum(linesPerSecond);
+        break;
     }
 
     renderMesh(modelScale, drawWireframe);
@@ -406,3 +429,53 @@ void AudioVis::updateMeshMagnitude(unsigned int linesPerSecond) {
           },
           linesPerSecond);
 }
+
+/*
+ * Unlike the other modes, this one does not look at the samples before the cursor again every frame.
+ * The sliding DFT only takes the samples that were played since the last frame,
+ * which costs the same for every sample, no matter how big the window is.
+ */
+void AudioVis::updateMeshSpectrum(unsigned int linesPerSecond) {
+    RECORD_SCOPE();
+
+    if (slidingDft == nullptr) {
+        return;
+    }
+    if (linesPerSecond == 0) {
+        linesPerSecond = 1;
+    }
+
+    const int channelCount = std::max(1, static_cast<int>(wav.header.numChannels));
+    const int samplesPerLine = std::max(1, static_cast<int>(wav.header.sampleRate) * channelCount /
+                                                 static_cast<int>(linesPerSecond));
+
+    // after seeking backwards or far ahead, the window is filled again with the samples right before the cursor
+    const int windowStart = playBack.sampleCursor - static_cast<int>(SPECTRUM_WINDOW_SIZE) * channelCount;
+    if (playBack.sampleCursor < spectrumCursor || spectrumCursor < windowStart) {
+        slidingDft->reset();
+        std::fill(spectrumLines.begin(), spectrumLines.end(), 0.0F);
+        spectrumCursor = std::max(0, windowStart);
+    }
+
+    const auto sampleCount = static_cast<int>(wav.data.subChunkSize / 2);
+    for (; spectrumCursor < playBack.sampleCursor && spectrumCursor < sampleCount; spectrumCursor++) {
+        // only the first channel
+        if (spectrumCursor % channelCount == 0) {
+            const auto sample = static_cast<float>(*(wav.data.data16 + spectrumCursor));
+            slidingDft->push(sample / static_cast<float>(std::numeric_limits<int16_t>::max()));
+        }
+
+        if (spectrumCursor % samplesPerLine == samplesPerLine - 1) {
+            std::copy_backward(spectrumLines.begin(), spectrumLines.end() - WIDTH, spectrumLines.end());
+            for (int column = 0; column < WIDTH; column++) {
+                spectrumLines[column] = slidingDft->magnitude(column);
+            }
+        }
+    }
+
+    const auto maxHeight = *std::max_element(spectrumLines.begin(), spectrumLines.end());
+    for (unsigned long i = 0; i < heightMap.size(); i++) {
+        heightMap[i] = maxHeight > 0.0F ? spectrumLines[i] / maxHeight : 0.0F;
+    }
+    heightBuffer->update(heightMap);
+}
@@ -7,6 +7,7 @@
 
 #include "WavLoader.h"
 #include "fourier_transform/Fourier.h"
+#include "fourier_transform/SlidingDft.h"
 #include "gl/Shader.h"
 #include "gl/VertexArray.h"
 #include "gl/VertexBuffer.h"
@@ -20,7 +21,7 @@ struct PlayBack {
 
 class AudioVis : public Scene {
   public:
-    enum class VisMode { AMPLITUDE = 0, PHASE = 1, FREQUENCY = 2, MAGNITUDE = 3 };
+    enum class VisMode { AMPLITUDE = 0, PHASE = 1, FREQUENCY = 2, MAGNITUDE = 3, SPECTRUM = 4 };
 
     explicit AudioVis() : Scene("AudioVis"){};
     ~AudioVis() override = default;
@@ -41,6 +42,12 @@ class AudioVis : public Scene {
     std::shared_ptr<VertexBuffer> heightBuffer = nullptr;
     std::vector<float> heightMap = {};
 
+    // follows the playback and tracks one bin per column of the mesh
+    std::shared_ptr<fourier::SlidingDft> slidingDft = nullptr;
+    int spectrumCursor = 0;
+    // the magnitudes of the bins at the end of every line, the newest line first
+    std::vector<float> spectrumLines = {};
+
     void initSoundIo(int sampleRate);
     void initMesh();
     void renderMesh(const glm::vec3 &modelScale, bool drawWireframe);
@@ -49,4 +56,5 @@ class AudioVis : public Scene {
     void updateMeshPhase(unsigned int linesPerSecond);
     void updateMeshFrequency(unsigned int linesPerSecond);
     void updateMeshMagnitude(unsigned int linesPerSecond);
+    void updateMeshSpectrum(unsigned int linesPerSecond);
 };
@@ -244,7 +244,14 @@ void DtmViewer::loadSaxonyDtmAsync() {
         }
 
         auto zipContainer = zipContainerOpt.value();
-        zipContainer.extract_to_directory(DTM_DIRECTORY_SAXONY);
+        auto reportOpt = zipContainer.extract_to_directory_in_parallel(DTM_DIRECTORY_SAXONY);
+        if (!reportOpt) {
+            std::cerr << "Failed to extract downloaded zip file: " << destinationFilepath << std::endl;
+            continue;
+        }
+        std::cout << "Extracted " << reportOpt->file_count << " files from " << destinationFilename << " with "
+                  << reportOpt->thread_count << " threads at " << reportOpt->get_throughput() << " MB/s"
+                  << std::endl;
     }
 
     loadLocalDtm(DTM_DIRECTORY_SAXONY, false);
@@ -303,8 +303,9 @@ void createTree(std::vector<GraphNode> &nodes, std::vector<GraphEdge> &edges) {
     }
     tree.insert(elements);
 
-    std::unordered_map<std::shared_ptr<QuadTree<unsigned int>::Node>, unsigned int> nodeToIndexMap = {};
-    tree.traversePostOrder([&nodeToIndexMap, &nodes, &edges](std::shared_ptr<QuadTree<unsigned int>::Node> node) {
+    using Tree = QuadTree<unsigned int>::Tree;
+    std::unordered_map<unsigned int, unsigned int> nodeToIndexMap = {};
+    tree.traversePostOrder([&nodeToIndexMap, &nodes, &edges](const Tree &t, unsigned int node) {
         unsigned int index = nodes.size();
         float x = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
         float y = static_cast<float>(std::rand()) / static_cast<float>(RAND_MAX);
@@ -312,11 +313,9 @@ void createTree(std::vector<GraphNode> &nodes, std::vector<GraphEdge> &edges) {
         y *= 10.0F;
         nodes.emplace_back(glm::vec2(x, y), glm::vec3(1.0F, 1.0F, 1.0F));
         nodeToIndexMap[node] = index;
-        if (node->left != nullptr) {
-            edges.push_back({index, nodeToIndexMap[node->left]});
-        }
-        if (node->right != nullptr) {
-            edges.push_back({index, nodeToIndexMap[node->right]});
+        if (!t.isLeaf(node)) {
+            edges.push_back({index, nodeToIndexMap[t.left(node)]});
+            edges.push_back({index, nodeToIndexMap[t.right(node)]});
         }
     });
 }
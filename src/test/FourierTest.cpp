@@ -1,8 +1,13 @@
 #include <gtest/gtest.h>
 
-#include <glm/glm.hpp>
+#include <glm/ext.hpp>
 
+#include "fourier_transform/Convolution.h"
+#include "fourier_transform/Fft2d.h"
+#include "fourier_transform/FftPlan.h"
 #include "fourier_transform/Fourier.h"
+#include "fourier_transform/SlidingDft.h"
+#include "fourier_transform/Spectrogram.h"
 
 TEST(FourierTest, can_calculate_a_simple_circle) {
     // GIVEN
@@ -18,3 +23,673 @@ TEST(FourierTest, can_calculate_a_simple_circle) {
     // THEN
     ASSERT_EQ(3, coefficients.size());
 }
+
+TEST(FourierTest, dft2_matches_the_sum_for_every_frequency) {
+    // a prime number of points and resolutions below and above half of them
+    for (const auto &[pointCount, resolution] :
+         std::vector<std::pair<unsigned int, unsigned int>>{{1, 2}, {4, 1}, {100, 30}, {997, 500}, {240, 500}}) {
+        std::vector<glm::vec2> points = {};
+        for (unsigned int i = 0; i < pointCount; i++) {
+            const auto t = glm::two_pi<float>() * static_cast<float>(i) / static_cast<float>(pointCount);
+            points.emplace_back(std::cos(t) + 0.3F * std::cos(5.0F * t), std::sin(t) - 0.2F * std::sin(3.0F * t));
+        }
+
+        const auto coefficients = fourier::dft2(points, resolution);
+        ASSERT_EQ(2 * resolution + 1, coefficients.size());
+        for (unsigned int i = 0; i < coefficients.size(); i++) {
+            const int frequency = static_cast<int>(i) - static_cast<int>(resolution);
+            std::complex<double> sum = {0, 0};
+            for (unsigned int n = 0; n < pointCount; n++) {
+                const double angle = glm::two_pi<double>() * frequency * n / pointCount;
+                sum += std::complex<double>(points[n].x, points[n].y) * std::polar(1.0, -angle);
+            }
+            sum /= static_cast<double>(pointCount);
+
+            ASSERT_EQ(frequency, coefficients[i].frequency);
+            ASSERT_NEAR(std::abs(sum), coefficients[i].magnitude, 1e-5) << pointCount << " " << frequency;
+            if (std::abs(sum) > 1e-3) {
+                const auto phase = std::polar(1.0, coefficients[i].phase);
+                const auto expectedPhase = std::polar(1.0, std::arg(sum));
+                ASSERT_NEAR(std::abs(phase - expectedPhase), 0.0, 1e-3) << pointCount << " " << frequency;
+            }
+        }
+    }
+}
+
+std::vector<std::complex<float>> naiveDft(const std::vector<std::complex<float>> &input, double sign) {
+    std::vector<std::complex<float>> result = {};
+    const auto N = static_cast<double>(input.size());
+    for (unsigned int k = 0; k < input.size(); k++) {
+        std::complex<double> sum = {0, 0};
+        for (unsigned int j = 0; j < input.size(); j++) {
+            const double angle = sign * glm::two_pi<double>() * static_cast<double>(j) * static_cast<double>(k) / N;
+            sum += std::complex<double>(input[j]) * std::complex<double>(std::cos(angle), std::sin(angle));
+        }
+        result.emplace_back(sum);
+    }
+    return result;
+}
+
+std::vector<std::complex<float>> createSignal(unsigned int size) {
+    std::vector<std::complex<float>> result = {};
+    for (unsigned int i = 0; i < size; i++) {
+        const auto t = static_cast<float>(i);
+        result.emplace_back(std::sin(0.3F * t) + 0.5F * std::cos(1.7F * t), 0.25F * std::sin(0.05F * t * t));
+    }
+    return result;
+}
+
+TEST(FourierTest, fft_plan_matches_naive_dft) {
+    for (const unsigned int size : {1U, 2U, 4U, 8U, 64U, 256U}) {
+        const auto input = createSignal(size);
+        const auto expected = naiveDft(input, -1.0);
+
+        auto plan = fourier::FftPlan(size);
+        auto actual = input;
+        ASSERT_TRUE(plan.forward(actual));
+        for (unsigned int i = 0; i < size; i++) {
+            ASSERT_NEAR(actual[i].real(), expected[i].real(), 1e-3F * size);
+            ASSERT_NEAR(actual[i].imag(), expected[i].imag(), 1e-3F * size);
+        }
+    }
+}
+
+TEST(FourierTest, fft_plan_inverse_restores_input) {
+    const unsigned int size = 1024;
+    const auto input = createSignal(size);
+
+    const auto &plan = fourier::cachedPlan(size);
+    auto data = input;
+    ASSERT_TRUE(plan.forward(data));
+    ASSERT_TRUE(plan.inverse(data));
+    for (unsigned int i = 0; i < size; i++) {
+        ASSERT_NEAR(data[i].real() / size, input[i].real(), 1e-4F);
+        ASSERT_NEAR(data[i].imag() / size, input[i].imag(), 1e-4F);
+    }
+}
+
+TEST(FourierTest, fft_plan_handles_sizes_that_are_not_powers_of_two) {
+    // mixed radix for the first ones, Bluestein for the ones with prime factors bigger than 7
+    for (const unsigned int size : {3U, 5U, 6U, 7U, 12U, 15U, 49U, 60U, 210U, 1000U, 11U, 13U, 26U, 97U, 1009U}) {
+        const auto input = createSignal(size);
+        const auto expected = naiveDft(input, -1.0);
+
+        const auto plan = fourier::FftPlan(size);
+        ASSERT_TRUE(plan.isValid());
+        auto actual = input;
+        ASSERT_TRUE(plan.forward(actual));
+        for (unsigned int i = 0; i < size; i++) {
+            ASSERT_NEAR(actual[i].real(), expected[i].real(), 1e-3F * size) << size;
+            ASSERT_NEAR(actual[i].imag(), expected[i].imag(), 1e-3F * size) << size;
+        }
+
+        ASSERT_TRUE(plan.inverse(actual));
+        for (unsigned int i = 0; i < size; i++) {
+            ASSERT_NEAR(actual[i].real() / size, input[i].real(), 1e-4F) << size;
+            ASSERT_NEAR(actual[i].imag() / size, input[i].imag(), 1e-4F) << size;
+        }
+    }
+}
+
+TEST(FourierTest, fft_plan_rejects_invalid_sizes) {
+    auto plan = fourier::FftPlan(0);
+    ASSERT_FALSE(plan.isValid());
+
+    auto data = createSignal(16);
+    ASSERT_FALSE(fourier::FftPlan(8).forward(data));
+}
+
+TEST(FourierTest, real_fft_matches_complex_fft) {
+    for (const unsigned int size : {1U, 2U, 3U, 4U, 8U, 10U, 15U, 32U, 98U, 105U, 1024U, 1031U}) {
+        std::vector<float> samples = {};
+        for (const auto &value : createSignal(size)) {
+            samples.push_back(value.real());
+        }
+
+        auto expected = std::vector<std::complex<float>>(samples.begin(), samples.end());
+        ASSERT_TRUE(fourier::FftPlan(size).forward(expected));
+
+        const auto plan = fourier::RealFftPlan(size);
+        auto bins = std::vector<std::complex<float>>(plan.binCount());
+        ASSERT_TRUE(plan.forward(samples, bins));
+        for (unsigned int k = 0; k < bins.size(); k++) {
+            ASSERT_NEAR(bins[k].real(), expected[k].real(), 1e-4F * size);
+            ASSERT_NEAR(bins[k].imag(), expected[k].imag(), 1e-4F * size);
+        }
+
+        auto restored = std::vector<float>(size);
+        ASSERT_TRUE(plan.inverse(bins, restored));
+        for (unsigned int i = 0; i < size; i++) {
+            ASSERT_NEAR(restored[i] / size, samples[i], 1e-4F);
+        }
+    }
+}
+
+TEST(FourierTest, double_fft_plans_match_naive_dft_closely) {
+    // power of two, mixed radix and Bluestein
+    for (const unsigned int size : {1024U, 1000U, 1031U}) {
+        std::vector<std::complex<double>> input = {};
+        for (const auto &value : createSignal(size)) {
+            input.emplace_back(value);
+        }
+
+        auto actual = input;
+        ASSERT_TRUE(fourier::DoubleFftPlan(size).forward(actual));
+        for (unsigned int k = 0; k < size; k++) {
+            std::complex<double> expected = {0, 0};
+            for (unsigned int j = 0; j < size; j++) {
+                expected += input[j] * std::polar(1.0, -glm::two_pi<double>() * ((j * k) % size) / size);
+            }
+            ASSERT_NEAR(actual[k].real(), expected.real(), 1e-10 * size) << size << " " << k;
+            ASSERT_NEAR(actual[k].imag(), expected.imag(), 1e-10 * size) << size << " " << k;
+        }
+
+        std::vector<double> samples = {};
+        for (const auto &value : input) {
+            samples.push_back(value.real());
+        }
+        auto expected = std::vector<std::complex<double>>(samples.begin(), samples.end());
+        ASSERT_TRUE(fourier::DoubleFftPlan(size).forward(expected));
+        const auto &plan = fourier::cachedRealPlan<double>(size);
+        auto bins = std::vector<std::complex<double>>(plan.binCount());
+        ASSERT_TRUE(plan.forward(samples, bins));
+        for (unsigned int k = 0; k < bins.size(); k++) {
+            ASSERT_NEAR(bins[k].real(), expected[k].real(), 1e-10 * size);
+            ASSERT_NEAR(bins[k].imag(), expected[k].imag(), 1e-10 * size);
+        }
+        auto restored = std::vector<double>(size);
+        ASSERT_TRUE(plan.inverse(bins, restored));
+        for (unsigned int i = 0; i < size; i++) {
+            ASSERT_NEAR(restored[i] / size, samples[i], 1e-12);
+        }
+    }
+}
+
+TEST(FourierTest, raw_transforms_match_data_points) {
+    const unsigned int size = 441;
+    std::vector<float> samples = {};
+    std::vector<glm::vec2> points = {};
+    std::vector<std::complex<float>> complexPoints = {};
+    for (const auto &value : createSignal(size)) {
+        samples.push_back(value.real());
+        points.emplace_back(value.real(), value.imag());
+        complexPoints.push_back(value);
+    }
+
+    const auto dataPoints = fourier::fft(samples, 44100);
+    auto bins = std::vector<std::complex<float>>(size / 2 + 1);
+    ASSERT_TRUE(fourier::fft<float>(samples, bins));
+    auto magnitudes = std::vector<float>(bins.size());
+    ASSERT_TRUE(fourier::fftMagnitudes<float>(samples, magnitudes));
+    auto doubleSamples = std::vector<double>(samples.begin(), samples.end());
+    auto doubleBins = std::vector<std::complex<double>>(bins.size());
+    ASSERT_TRUE(fourier::fft<double>(doubleSamples, doubleBins));
+    ASSERT_EQ(dataPoints.size(), bins.size());
+    for (unsigned int bin = 0; bin < bins.size(); bin++) {
+        ASSERT_NEAR(std::abs(bins[bin]), dataPoints[bin].magnitude, 1e-4);
+        ASSERT_NEAR(magnitudes[bin], dataPoints[bin].magnitude, 1e-4);
+        ASSERT_NEAR(doubleBins[bin].real(), bins[bin].real(), 1e-3);
+        ASSERT_NEAR(doubleBins[bin].imag(), bins[bin].imag(), 1e-3);
+    }
+    ASSERT_FALSE(fourier::fft<float>(samples, std::span(bins).first(10)));
+
+    const unsigned int resolution = 300;
+    const auto expected = fourier::dft2(points, resolution);
+    auto coefficients = std::vector<std::complex<float>>(2 * resolution + 1);
+    ASSERT_TRUE(fourier::dft2<float>(complexPoints, resolution, coefficients));
+    ASSERT_EQ(expected.size(), coefficients.size());
+    for (unsigned int i = 0; i < coefficients.size(); i++) {
+        ASSERT_NEAR(std::abs(coefficients[i]), expected[i].magnitude, 1e-6);
+        ASSERT_NEAR(std::abs(coefficients[i] - std::polar(static_cast<float>(expected[i].magnitude),
+                                                          static_cast<float>(expected[i].phase))),
+                    0.0, 1e-6);
+    }
+    ASSERT_FALSE(fourier::dft2<float>(complexPoints, resolution + 1, coefficients));
+}
+
+TEST(FourierTest, fft_matches_dft_for_any_length) {
+    for (const unsigned int size : {16U, 100U, 441U, 1000U, 1031U}) {
+        std::vector<float> samples = {};
+        for (const auto &value : createSignal(size)) {
+            samples.push_back(value.real());
+        }
+
+        const auto actual = fourier::fft(samples, 44100);
+        const auto expected = fourier::dft(samples, 44100);
+        ASSERT_EQ(expected.size(), actual.size());
+        for (unsigned int bin = 0; bin < actual.size(); bin++) {
+            ASSERT_NEAR(actual[bin].frequency, expected[bin].frequency, 1e-6);
+            // dft returns the magnitude in dB divided by the size and the phase in a different unit
+            const auto magnitude = 20.0 * std::log10(2.0 * actual[bin].magnitude) / size;
+            ASSERT_NEAR(magnitude, expected[bin].magnitude, 1e-4) << size << " " << bin;
+            if (actual[bin].magnitude > 1e-2) {
+                const auto phase = std::polar(1.0, actual[bin].phase * glm::pi<double>() / 180.0);
+                const auto expectedPhase = std::polar(1.0, (expected[bin].phase + 90.0) * glm::pi<double>() / 100.0);
+                ASSERT_NEAR(std::abs(phase - expectedPhase), 0.0, 1e-2) << size << " " << bin;
+            }
+        }
+    }
+}
+
+std::vector<const fourier::FftKernel *> supportedKernels() {
+    std::vector<const fourier::FftKernel *> result = {&fourier::scalarFftKernel()};
+    const auto &best = fourier::bestFftKernel();
+    // a CPU with AVX2 also supports SSE3
+    if (&best == fourier::avx2FftKernel() && fourier::sse3FftKernel() != nullptr) {
+        result.push_back(fourier::sse3FftKernel());
+    }
+    if (&best != result.front()) {
+        result.push_back(&best);
+    }
+    return result;
+}
+
+TEST(FourierTest, all_fft_kernels_match_naive_dft) {
+    for (const auto *kernel : supportedKernels()) {
+        for (const unsigned int size : {2U, 4U, 8U, 16U, 32U, 128U, 512U}) {
+            const auto input = createSignal(size);
+            const auto expected = naiveDft(input, -1.0);
+
+            auto actual = input;
+            ASSERT_TRUE(fourier::FftPlan(size, *kernel).forward(actual));
+            for (unsigned int i = 0; i < size; i++) {
+                ASSERT_NEAR(actual[i].real(), expected[i].real(), 1e-3F * size) << kernel->name;
+                ASSERT_NEAR(actual[i].imag(), expected[i].imag(), 1e-3F * size) << kernel->name;
+            }
+        }
+    }
+}
+
+TEST(FourierTest, all_fft_kernels_agree_on_blocked_sizes) {
+    // bigger than one block, so that both the blocked and the full passes are used
+    for (const unsigned int size : {1U << 13, 1U << 14}) {
+        const auto input = createSignal(size);
+        auto expected = input;
+        ASSERT_TRUE(fourier::FftPlan(size, fourier::scalarFftKernel()).forward(expected));
+
+        for (const auto *kernel : supportedKernels()) {
+            const auto plan = fourier::FftPlan(size, *kernel);
+            auto actual = input;
+            ASSERT_TRUE(plan.forward(actual));
+            for (unsigned int i = 0; i < size; i++) {
+                ASSERT_NEAR(actual[i].real(), expected[i].real(), 1e-2F) << kernel->name;
+                ASSERT_NEAR(actual[i].imag(), expected[i].imag(), 1e-2F) << kernel->name;
+            }
+
+            ASSERT_TRUE(plan.inverse(actual));
+            for (unsigned int i = 0; i < size; i++) {
+                ASSERT_NEAR(actual[i].real() / size, input[i].real(), 1e-4F) << kernel->name;
+                ASSERT_NEAR(actual[i].imag() / size, input[i].imag(), 1e-4F) << kernel->name;
+            }
+        }
+    }
+}
+
+TEST(FourierTest, fft_of_big_sizes_matches_single_bins) {
+    // big enough for the tiled bit reversal, a naive DFT of all bins would take too long
+    for (const unsigned int size : {1U << 16, 1U << 17}) {
+        const auto input = createSignal(size);
+        auto actual = input;
+        ASSERT_TRUE(fourier::FftPlan(size).forward(actual));
+
+        for (const unsigned int k : {0U, 1U, 7U, size / 3, size / 2 + 5, size - 1}) {
+            std::complex<double> expected = 0.0;
+            for (unsigned int j = 0; j < size; j++) {
+                // reduced modulo size, so that the angle stays small and precise
+                const auto turns = static_cast<double>((static_cast<uint64_t>(j) * k) % size);
+                const double angle = -glm::two_pi<double>() * turns / static_cast<double>(size);
+                expected += std::complex<double>(input[j]) * std::complex<double>(std::cos(angle), std::sin(angle));
+            }
+            ASSERT_NEAR(actual[k].real(), expected.real(), 1e-1) << size << " " << k;
+            ASSERT_NEAR(actual[k].imag(), expected.imag(), 1e-1) << size << " " << k;
+        }
+    }
+}
+
+TEST(FourierTest, stft_matches_naive_dft_of_windowed_frames) {
+    const auto input = createSignal(200);
+    auto samples = std::vector<float>();
+    for (const auto &value : input) {
+        samples.push_back(value.real());
+    }
+
+    const auto spectrogram = fourier::stft(samples, 64, 24);
+    ASSERT_EQ(64, spectrogram.frameSize);
+    ASSERT_EQ(33, spectrogram.binCount);
+    // frames start at 0, 24, ..., 120, the next one would end behind the samples
+    ASSERT_EQ(6, spectrogram.frameCount);
+    ASSERT_EQ(6 * 33, spectrogram.magnitudes.size());
+    ASSERT_EQ(6 * 33, spectrogram.phases.size());
+
+    const auto window = fourier::windowCoefficients(fourier::Window::Hann, 64);
+    for (size_t frame = 0; frame < spectrogram.frameCount; frame++) {
+        auto windowed = std::vector<std::complex<float>>();
+        for (size_t i = 0; i < 64; i++) {
+            windowed.emplace_back(samples[frame * 24 + i] * window[i]);
+        }
+        const auto expected = naiveDft(windowed, -1.0);
+        for (size_t bin = 0; bin < spectrogram.binCount; bin++) {
+            ASSERT_NEAR(spectrogram.magnitude(frame, bin), std::abs(expected[bin]), 1e-3F);
+            if (std::abs(expected[bin]) > 1e-2F) {
+                // compared as points on the unit circle, so that -pi and pi are the same
+                const auto actualPhase = std::polar(1.0F, spectrogram.phase(frame, bin));
+                const auto expectedPhase = std::polar(1.0F, std::arg(expected[bin]));
+                ASSERT_NEAR(std::abs(actualPhase - expectedPhase), 0.0F, 1e-3F);
+            }
+        }
+    }
+}
+
+TEST(FourierTest, stft_finds_the_frequency_of_a_sine) {
+    const unsigned int sampleRate = 8000;
+    auto samples = std::vector<float>();
+    for (unsigned int i = 0; i < sampleRate; i++) {
+        samples.push_back(std::sin(glm::two_pi<float>() * 1000.0F * static_cast<float>(i) / sampleRate));
+    }
+
+    const auto spectrogram = fourier::stft(samples, 256, 128, fourier::Window::Blackman);
+    ASSERT_EQ(61, spectrogram.frameCount);
+    for (size_t frame = 0; frame < spectrogram.frameCount; frame++) {
+        const auto magnitudes = spectrogram.frameMagnitudes(frame);
+        const auto loudestBin = std::max_element(magnitudes.begin(), magnitudes.end()) - magnitudes.begin();
+        ASSERT_DOUBLE_EQ(1000.0, spectrogram.frequency(loudestBin, sampleRate));
+    }
+}
+
+TEST(FourierTest, stft_without_a_full_frame_is_empty) {
+    const auto samples = std::vector<float>(100, 1.0F);
+    ASSERT_EQ(0, fourier::stft(samples, 128, 32).frameCount);
+    ASSERT_EQ(0, fourier::stft(samples, 0, 32).binCount);
+    ASSERT_EQ(0, fourier::stft(samples, 64, 0).binCount);
+}
+
+TEST(FourierTest, ifft_restores_the_input_of_fft) {
+    for (const unsigned int size : {1U, 16U, 99U, 1000U}) {
+        std::vector<float> samples = {};
+        for (const auto &value : createSignal(size)) {
+            samples.push_back(value.real());
+        }
+
+        const auto restored = fourier::ifft(fourier::fft(samples, 44100), size);
+        ASSERT_EQ(size, restored.size());
+        for (unsigned int i = 0; i < size; i++) {
+            ASSERT_NEAR(restored[i], samples[i], 1e-4F) << size;
+        }
+    }
+}
+
+std::vector<float> createSamples(unsigned int size) {
+    std::vector<float> result = {};
+    for (const auto &value : createSignal(size)) {
+        result.push_back(value.real());
+    }
+    return result;
+}
+
+// the full convolution, computed in double
+std::vector<double> naiveConvolution(const std::vector<float> &signal, const std::vector<float> &kernel) {
+    auto result = std::vector<double>(signal.size() + kernel.size() - 1, 0.0);
+    for (size_t i = 0; i < signal.size(); i++) {
+        for (size_t j = 0; j < kernel.size(); j++) {
+            result[i + j] += static_cast<double>(signal[i]) * static_cast<double>(kernel[j]);
+        }
+    }
+    return result;
+}
+
+TEST(FourierTest, convolve_matches_naive_convolution) {
+    // direct and FFT-based, with kernels that are shorter and longer than the signal
+    for (const auto &[signalSize, kernelSize] : std::vector<std::pair<unsigned int, unsigned int>>{
+               {1000, 1}, {1000, 7}, {1000, 64}, {1000, 65}, {5000, 300}, {100, 999}, {1, 1}}) {
+        const auto signal = createSamples(signalSize);
+        auto kernel = createSamples(kernelSize + 3);
+        kernel.erase(kernel.begin(), kernel.begin() + 3);
+        const auto expected = naiveConvolution(signal, kernel);
+
+        const auto full = fourier::convolve(signal, kernel);
+        ASSERT_EQ(expected.size(), full.size());
+        for (size_t n = 0; n < full.size(); n++) {
+            ASSERT_NEAR(full[n], expected[n], 1e-3) << signalSize << " " << kernelSize << " " << n;
+        }
+
+        const auto same = fourier::convolve(signal, kernel, fourier::ConvolutionMode::Same);
+        ASSERT_EQ(signalSize, same.size());
+        for (size_t n = 0; n < same.size(); n++) {
+            ASSERT_NEAR(same[n], expected[n + (kernelSize - 1) / 2], 1e-3) << signalSize << " " << kernelSize;
+        }
+
+        const auto valid = fourier::convolve(signal, kernel, fourier::ConvolutionMode::Valid);
+        ASSERT_EQ(fourier::convolutionSize(signalSize, kernelSize, fourier::ConvolutionMode::Valid), valid.size());
+        for (size_t n = 0; n < valid.size(); n++) {
+            ASSERT_NEAR(valid[n], expected[n + kernelSize - 1], 1e-3) << signalSize << " " << kernelSize;
+        }
+    }
+}
+
+TEST(FourierTest, correlate_matches_naive_correlation) {
+    const auto signal = createSamples(3000);
+    for (const auto size : {5U, 200U}) {
+        const auto kernel = createSamples(size);
+        const auto correlation = fourier::correlate(signal, kernel);
+        ASSERT_EQ(3000 + size - 1, correlation.size());
+        for (size_t n = 0; n < correlation.size(); n++) {
+            double expected = 0.0;
+            for (size_t j = 0; j < size; j++) {
+                const auto index = static_cast<ptrdiff_t>(n + j) - static_cast<ptrdiff_t>(size - 1);
+                if (index >= 0 && index < 3000) {
+                    expected += static_cast<double>(signal[index]) * static_cast<double>(kernel[j]);
+                }
+            }
+            ASSERT_NEAR(correlation[n], expected, 1e-3) << size << " " << n;
+        }
+    }
+}
+
+TEST(FourierTest, correlate_finds_a_shifted_pattern) {
+    const auto pattern = createSamples(200);
+    auto signal = std::vector<float>(3000, 0.0F);
+    std::copy(pattern.begin(), pattern.end(), signal.begin() + 1234);
+
+    const auto correlation = fourier::correlate(signal, pattern, fourier::ConvolutionMode::Valid);
+    ASSERT_EQ(3000 - 200 + 1, correlation.size());
+    const auto best = std::max_element(correlation.begin(), correlation.end()) - correlation.begin();
+    ASSERT_EQ(1234, best);
+}
+
+TEST(FourierTest, convolve2d_matches_naive_convolution) {
+    const size_t width = 37;
+    const size_t height = 23;
+    const auto values = createSamples(width * height);
+    // direct and FFT-based, which is only used for kernels that are big compared to the grid
+    for (const auto &[kernelWidth, kernelHeight] :
+         std::vector<std::pair<size_t, size_t>>{{3, 3}, {1, 5}, {7, 7}, {11, 9}, {40, 2}, {19, 17}, {40, 30}}) {
+        const auto kernel = createSamples(kernelWidth * kernelHeight);
+        const auto fullWidth = width + kernelWidth - 1;
+        const auto fullHeight = height + kernelHeight - 1;
+        auto expected = std::vector<double>(fullWidth * fullHeight, 0.0);
+        for (size_t y = 0; y < height; y++) {
+            for (size_t x = 0; x < width; x++) {
+                for (size_t ky = 0; ky < kernelHeight; ky++) {
+                    for (size_t kx = 0; kx < kernelWidth; kx++) {
+                        expected[(y + ky) * fullWidth + x + kx] += static_cast<double>(values[y * width + x]) *
+                                                                   static_cast<double>(kernel[ky * kernelWidth + kx]);
+                    }
+                }
+            }
+        }
+
+        for (const auto mode :
+             {fourier::ConvolutionMode::Full, fourier::ConvolutionMode::Same, fourier::ConvolutionMode::Valid}) {
+            const auto actual = fourier::convolve2d(values, width, height, kernel, kernelWidth, kernelHeight, mode);
+            const auto outputWidth = fourier::convolutionSize(width, kernelWidth, mode);
+            const auto outputHeight = fourier::convolutionSize(height, kernelHeight, mode);
+            ASSERT_EQ(outputWidth * outputHeight, actual.size());
+            const auto beginX = mode == fourier::ConvolutionMode::Full   ? 0
+                                : mode == fourier::ConvolutionMode::Same ? (kernelWidth - 1) / 2
+                                                                         : kernelWidth - 1;
+            const auto beginY = mode == fourier::ConvolutionMode::Full   ? 0
+                                : mode == fourier::ConvolutionMode::Same ? (kernelHeight - 1) / 2
+                                                                         : kernelHeight - 1;
+            for (size_t y = 0; y < outputHeight; y++) {
+                for (size_t x = 0; x < outputWidth; x++) {
+                    ASSERT_NEAR(actual[y * outputWidth + x], expected[(y + beginY) * fullWidth + x + beginX], 1e-3)
+                          << kernelWidth << "x" << kernelHeight << " " << x << " " << y;
+                }
+            }
+        }
+    }
+}
+
+TEST(FourierTest, real_fft2d_matches_naive_dft) {
+    // odd and even sizes, one of them wider than a strip of columns
+    for (const auto &[width, height] : std::vector<std::pair<size_t, size_t>>{{8, 8}, {12, 7}, {5, 16}, {37, 23}}) {
+        const auto values = createSamples(width * height);
+        const auto plan = fourier::RealFft2dPlan(width, height);
+        ASSERT_EQ((width / 2 + 1) * height, plan.binCount());
+        auto bins = std::vector<std::complex<float>>(plan.binCount());
+        ASSERT_TRUE(plan.forward(values, bins));
+
+        for (size_t ky = 0; ky < height; ky++) {
+            for (size_t kx = 0; kx < plan.binWidth(); kx++) {
+                auto expected = std::complex<double>(0.0, 0.0);
+                for (size_t y = 0; y < height; y++) {
+                    for (size_t x = 0; x < width; x++) {
+                        const auto angle = -glm::two_pi<double>() * (static_cast<double>(kx * x) / width +
+                                                                     static_cast<double>(ky * y) / height);
+                        expected += static_cast<double>(values[y * width + x]) * std::polar(1.0, angle);
+                    }
+                }
+                const auto actual = bins[ky * plan.binWidth() + kx];
+                ASSERT_NEAR(actual.real(), expected.real(), 1e-3) << width << "x" << height << " " << kx << " " << ky;
+                ASSERT_NEAR(actual.imag(), expected.imag(), 1e-3) << width << "x" << height << " " << kx << " " << ky;
+            }
+        }
+
+        auto restored = std::vector<float>(values.size());
+        ASSERT_TRUE(plan.inverse(bins, restored));
+        for (size_t i = 0; i < values.size(); i++) {
+            ASSERT_NEAR(restored[i] / static_cast<float>(width * height), values[i], 1e-4);
+        }
+    }
+
+    auto bins = std::vector<std::complex<float>>(4);
+    ASSERT_FALSE(fourier::RealFft2dPlan(4, 4).forward(createSamples(16), bins));
+    ASSERT_FALSE(fourier::RealFft2dPlan(0, 4).isValid());
+}
+
+TEST(FourierTest, cached_real_fft2d_plan_is_reused_per_size) {
+    const auto &plan = fourier::cachedRealFft2dPlan(16, 8);
+    ASSERT_EQ(16, plan.width());
+    ASSERT_EQ(8, plan.height());
+    ASSERT_EQ(&plan, &fourier::cachedRealFft2dPlan(16, 8));
+    ASSERT_NE(&plan, &fourier::cachedRealFft2dPlan(8, 16));
+}
+
+TEST(FourierTest, gaussian_blur_spreads_a_point_like_a_gaussian) {
+    const size_t width = 64;
+    const size_t height = 48;
+    const auto sigma = 3.0F;
+    auto values = std::vector<float>(width * height, 0.0F);
+    values[20 * width + 30] = 1.0F;
+    ASSERT_TRUE(fourier::gaussianBlur(values, width, height, sigma));
+
+    for (size_t y = 0; y < height; y++) {
+        for (size_t x = 0; x < width; x++) {
+            const auto dx = static_cast<double>(x) - 30.0;
+            const auto dy = static_cast<double>(y) - 20.0;
+            const auto expected = std::exp(-(dx * dx + dy * dy) / (2.0 * sigma * sigma)) /
+                                  (glm::two_pi<double>() * sigma * sigma);
+            ASSERT_NEAR(values[y * width + x], expected, 1e-4) << x << " " << y;
+        }
+    }
+
+    // every channel on its own, a constant channel stays the same
+    auto pixels = std::vector<uint8_t>(width * height * 3, 0);
+    for (size_t i = 0; i < width * height; i++) {
+        pixels[i * 3] = 200;
+        pixels[i * 3 + 1] = (i % width) < width / 2 ? 0 : 255;
+    }
+    ASSERT_TRUE(fourier::gaussianBlur(pixels, width, height, 3, sigma));
+    for (size_t i = 0; i < width * height; i++) {
+        ASSERT_EQ(pixels[i * 3], 200);
+        ASSERT_EQ(pixels[i * 3 + 2], 0);
+    }
+    // the edge between the halves is smooth now
+    ASSERT_GT(pixels[(10 * width + width / 2) * 3 + 1], 100);
+    ASSERT_LT(pixels[(10 * width + width / 2) * 3 + 1], 200);
+    ASSERT_FALSE(fourier::gaussianBlur(pixels, width, height, 4, sigma));
+}
+
+TEST(FourierTest, sliding_dft_matches_dft_of_the_last_window) {
+    const unsigned int windowSize = 64;
+    const auto samples = createSamples(1000);
+    const std::vector<unsigned int> bins = {0, 1, 5, 31, 32, 63};
+    auto slidingDft = fourier::SlidingDft(windowSize, bins, 1.0);
+
+    for (unsigned int end = 1; end <= samples.size(); end++) {
+        slidingDft.push(samples[end - 1]);
+        if (end % 97 != 0 && end != 10) {
+            continue;
+        }
+
+        // the samples before the first one count as 0
+        auto window = std::vector<std::complex<float>>(windowSize, 0.0F);
+        for (unsigned int i = 0; i < windowSize; i++) {
+            if (end + i >= windowSize) {
+                window[i] = samples[end + i - windowSize];
+            }
+        }
+        const auto expected = naiveDft(window, -1.0);
+        for (unsigned int i = 0; i < bins.size(); i++) {
+            ASSERT_NEAR(slidingDft.value(i).real(), expected[bins[i]].real(), 1e-3F) << end << " " << bins[i];
+            ASSERT_NEAR(slidingDft.value(i).imag(), expected[bins[i]].imag(), 1e-3F) << end << " " << bins[i];
+        }
+    }
+}
+
+TEST(FourierTest, damped_sliding_dft_stays_accurate_over_many_samples) {
+    const unsigned int windowSize = 256;
+    const double damping = 0.999;
+    const std::vector<unsigned int> bins = {3, 100};
+    auto slidingDft = fourier::SlidingDft(windowSize, bins, damping);
+    const auto samples = createSamples(1000000);
+    slidingDft.push(samples);
+
+    for (unsigned int i = 0; i < bins.size(); i++) {
+        // the sample m of the window is weighted with damping^(windowSize - m)
+        std::complex<double> expected = 0.0;
+        for (unsigned int m = 0; m < windowSize; m++) {
+            const auto sample = static_cast<double>(samples[samples.size() - windowSize + m]);
+            const double angle = -glm::two_pi<double>() * bins[i] * m / windowSize;
+            expected += sample * std::pow(damping, windowSize - m) * std::polar(1.0, angle);
+        }
+        ASSERT_NEAR(slidingDft.value(i).real(), expected.real(), 1e-3);
+        ASSERT_NEAR(slidingDft.value(i).imag(), expected.imag(), 1e-3);
+    }
+}
+
+TEST(FourierTest, goertzel_matches_naive_dft) {
+    const auto input = createSignal(300);
+    auto samples = std::vector<float>();
+    auto window = std::vector<std::complex<float>>();
+    for (const auto &value : input) {
+        samples.push_back(value.real());
+        window.emplace_back(value.real());
+    }
+    const auto expected = naiveDft(window, -1.0);
+
+    for (const unsigned int bin : {0U, 1U, 17U, 150U, 299U}) {
+        const auto actual = fourier::goertzel(samples, bin);
+        ASSERT_NEAR(actual.real(), expected[bin].real(), 1e-3F) << bin;
+        ASSERT_NEAR(actual.imag(), expected[bin].imag(), 1e-3F) << bin;
+    }
+
+    // between two bins
+    std::complex<double> between = 0.0;
+    for (unsigned int n = 0; n < samples.size(); n++) {
+        between += static_cast<double>(samples[n]) * std::polar(1.0, -glm::two_pi<double>() * 17.5 * n / 300.0);
+    }
+    const auto actual = fourier::goertzel(samples, 17.5);
+    ASSERT_NEAR(actual.real(), between.real(), 1e-3);
+    ASSERT_NEAR(actual.imag(), between.imag(), 1e-3);
+}
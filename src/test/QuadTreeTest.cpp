@@ -1,8 +1,13 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <glm/glm.hpp>
 #include <gtest/gtest.h>
 
 #include "quad_tree/QuadTree.h"
 
+using Tree = QuadTree<unsigned int>::Tree;
+
 TEST(QuadTreeTest, can_add_one_element) {
     auto tree = QuadTree<unsigned int>(10);
 
@@ -10,14 +15,13 @@ TEST(QuadTreeTest, can_add_one_element) {
     unsigned int elem = 123;
     tree.insert(point, elem);
 
-    ASSERT_EQ(tree.elements.size(), 1);
-    ASSERT_EQ(tree.root->parity, 0);
-    ASSERT_EQ(tree.root->left, nullptr);
-    ASSERT_EQ(tree.root->right, nullptr);
-    ASSERT_EQ(tree.root->begin->first, point);
-    ASSERT_EQ(tree.root->begin->second, elem);
-    ASSERT_EQ(tree.root->bb.min, glm::vec3(1.0F));
-    ASSERT_EQ(tree.root->bb.max, glm::vec3(1.0F));
+    ASSERT_EQ(tree.size(), 1);
+    ASSERT_EQ(tree.trees[0].nodes.size(), 1);
+    ASSERT_TRUE(tree.trees[0].isLeaf(Tree::ROOT));
+    ASSERT_EQ(tree.trees[0].point(tree.trees[0].nodes[Tree::ROOT].begin), point);
+    ASSERT_EQ(tree.trees[0].value(tree.trees[0].nodes[Tree::ROOT].begin), elem);
+    ASSERT_EQ(tree.trees[0].nodes[Tree::ROOT].bb.min, glm::vec3(1.0F));
+    ASSERT_EQ(tree.trees[0].nodes[Tree::ROOT].bb.max, glm::vec3(1.0F));
 }
 
 TEST(QuadTreeTest, can_add_multiple_elements) {
@@ -30,14 +34,13 @@ TEST(QuadTreeTest, can_add_multiple_elements) {
     };
     tree.insert(elements);
 
-    ASSERT_EQ(tree.elements.size(), 3);
-    ASSERT_EQ(tree.root->parity, 0);
-    ASSERT_EQ(tree.root->left, nullptr);
-    ASSERT_EQ(tree.root->right, nullptr);
-    ASSERT_EQ(tree.root->begin->first, glm::vec3(1.0F));
-    ASSERT_EQ(tree.root->begin->second, 1);
-    ASSERT_EQ(tree.root->bb.min, glm::vec3(1.0F));
-    ASSERT_EQ(tree.root->bb.max, glm::vec3(3.0F));
+    ASSERT_EQ(tree.size(), 3);
+    ASSERT_EQ(tree.trees[0].nodes.size(), 1);
+    ASSERT_TRUE(tree.trees[0].isLeaf(Tree::ROOT));
+    ASSERT_EQ(tree.trees[0].point(tree.trees[0].nodes[Tree::ROOT].begin), glm::vec3(1.0F));
+    ASSERT_EQ(tree.trees[0].value(tree.trees[0].nodes[Tree::ROOT].begin), 1);
+    ASSERT_EQ(tree.trees[0].nodes[Tree::ROOT].bb.min, glm::vec3(1.0F));
+    ASSERT_EQ(tree.trees[0].nodes[Tree::ROOT].bb.max, glm::vec3(3.0F));
 }
 
 TEST(QuadTreeTest, can_add_multiple_unordered_elements) {
@@ -50,14 +53,13 @@ TEST(QuadTreeTest, can_add_multiple_unordered_elements) {
     };
     tree.insert(elements);
 
-    ASSERT_EQ(tree.elements.size(), 3);
-    ASSERT_EQ(tree.root->parity, 0);
-    ASSERT_EQ(tree.root->left, nullptr);
-    ASSERT_EQ(tree.root->right, nullptr);
-    ASSERT_EQ(tree.root->begin->first, glm::vec3(1.0F));
-    ASSERT_EQ(tree.root->begin->second, 1);
-    ASSERT_EQ(tree.root->bb.min, glm::vec3(1.0F));
-    ASSERT_EQ(tree.root->bb.max, glm::vec3(3.0F));
+    ASSERT_EQ(tree.size(), 3);
+    ASSERT_EQ(tree.trees[0].nodes.size(), 1);
+    ASSERT_TRUE(tree.trees[0].isLeaf(Tree::ROOT));
+    ASSERT_EQ(tree.trees[0].point(tree.trees[0].nodes[Tree::ROOT].begin), glm::vec3(1.0F));
+    ASSERT_EQ(tree.trees[0].value(tree.trees[0].nodes[Tree::ROOT].begin), 1);
+    ASSERT_EQ(tree.trees[0].nodes[Tree::ROOT].bb.min, glm::vec3(1.0F));
+    ASSERT_EQ(tree.trees[0].nodes[Tree::ROOT].bb.max, glm::vec3(3.0F));
 }
 
 TEST(QuadTreeTest, branches_correctly) {
@@ -71,22 +73,30 @@ TEST(QuadTreeTest, branches_correctly) {
     };
     tree.insert(elements);
 
-    ASSERT_EQ(tree.elements.size(), 4);
-    ASSERT_EQ(tree.root->parity, 0);
-    ASSERT_EQ(tree.root->begin->first, glm::vec3(1.0F));
-    ASSERT_EQ(tree.root->begin->second, 1);
-    ASSERT_EQ(tree.root->bb.min, glm::vec3(1.0F));
-    ASSERT_EQ(tree.root->bb.max, glm::vec3(4.0F));
-
-    ASSERT_NE(tree.root->left, nullptr);
-    ASSERT_EQ(tree.root->left->begin->first, glm::vec3(1.0F));
-    ASSERT_EQ((tree.root->left->begin + 1)->first, glm::vec3(2.0F));
-    ASSERT_EQ((tree.root->left->begin + 2), tree.root->left->end);
-
-    ASSERT_NE(tree.root->right, nullptr);
-    ASSERT_EQ(tree.root->right->begin->first, glm::vec3(3.0F));
-    ASSERT_EQ((tree.root->right->begin + 1)->first, glm::vec3(4.0F));
-    ASSERT_EQ((tree.root->right->begin + 2), tree.root->right->end);
+    ASSERT_EQ(tree.size(), 4);
+    ASSERT_EQ(tree.trees[0].nodes.size(), 3);
+    ASSERT_EQ(Tree::axis(Tree::ROOT), DefaultSplitAxes<3>::VALUES[0]);
+    ASSERT_EQ(tree.trees[0].point(tree.trees[0].nodes[Tree::ROOT].begin), glm::vec3(1.0F));
+    ASSERT_EQ(tree.trees[0].value(tree.trees[0].nodes[Tree::ROOT].begin), 1);
+    ASSERT_EQ(tree.trees[0].nodes[Tree::ROOT].bb.min, glm::vec3(1.0F));
+    ASSERT_EQ(tree.trees[0].nodes[Tree::ROOT].bb.max, glm::vec3(4.0F));
+
+    ASSERT_FALSE(tree.trees[0].isLeaf(Tree::ROOT));
+    const auto left = Tree::left(Tree::ROOT);
+    ASSERT_TRUE(tree.trees[0].isLeaf(left));
+    ASSERT_EQ(tree.trees[0].point(tree.trees[0].nodes[left].begin), glm::vec3(1.0F));
+    ASSERT_EQ(tree.trees[0].point(tree.trees[0].nodes[left].begin + 1), glm::vec3(2.0F));
+    ASSERT_EQ(tree.trees[0].nodes[left].begin + 2, tree.trees[0].nodes[left].end);
+
+    const auto right = Tree::right(Tree::ROOT);
+    ASSERT_TRUE(tree.trees[0].isLeaf(right));
+    ASSERT_EQ(tree.trees[0].point(tree.trees[0].nodes[right].begin), glm::vec3(3.0F));
+    ASSERT_EQ(tree.trees[0].point(tree.trees[0].nodes[right].begin + 1), glm::vec3(4.0F));
+    ASSERT_EQ(tree.trees[0].nodes[right].begin + 2, tree.trees[0].nodes[right].end);
+
+    // the root splits its elements along its axis
+    const auto axis = Tree::axis(Tree::ROOT);
+    ASSERT_LE(tree.trees[0].nodes[left].bb.max[axis], tree.trees[0].nodes[right].bb.min[axis]);
 }
 
 TEST(QuadTreeTest, fails_if_there_are_no_elements) {
@@ -179,13 +189,13 @@ TEST(QuadTreeTest, can_traverse_branched_tree_in_pre_order) {
     tree.insert(elements);
 
     int count = 0;
-    tree.traversePreOrder([&count](std::shared_ptr<QuadTree<unsigned int>::Node> node) {
+    tree.traversePreOrder([&count](const Tree &t, unsigned int node) {
         if (count == 0) {
-            ASSERT_TRUE(!node->isLeaf());
+            ASSERT_TRUE(!t.isLeaf(node));
         } else if (count == 1) {
-            ASSERT_TRUE(node->isLeaf());
+            ASSERT_TRUE(t.isLeaf(node));
         } else if (count == 2) {
-            ASSERT_TRUE(node->isLeaf());
+            ASSERT_TRUE(t.isLeaf(node));
         } else if (count > 2) {
             FAIL();
         }
@@ -206,13 +216,13 @@ TEST(QuadTreeTest, can_traverse_branched_tree_in_post_order) {
     tree.insert(elements);
 
     int count = 0;
-    tree.traversePostOrder([&count](std::shared_ptr<QuadTree<unsigned int>::Node> node) {
+    tree.traversePostOrder([&count](const Tree &t, unsigned int node) {
         if (count == 0) {
-            ASSERT_TRUE(node->isLeaf());
+            ASSERT_TRUE(t.isLeaf(node));
         } else if (count == 1) {
-            ASSERT_TRUE(node->isLeaf());
+            ASSERT_TRUE(t.isLeaf(node));
         } else if (count == 2) {
-            ASSERT_TRUE(!node->isLeaf());
+            ASSERT_TRUE(!t.isLeaf(node));
         } else if (count > 2) {
             FAIL();
         }
@@ -233,13 +243,13 @@ TEST(QuadTreeTest, can_traverse_branched_tree_in_inOrder) {
     tree.insert(elements);
 
     int count = 0;
-    tree.traverseInOrder([&count](std::shared_ptr<QuadTree<unsigned int>::Node> node) {
+    tree.traverseInOrder([&count](const Tree &t, unsigned int node) {
         if (count == 0) {
-            ASSERT_TRUE(node->isLeaf());
+            ASSERT_TRUE(t.isLeaf(node));
         } else if (count == 1) {
-            ASSERT_TRUE(!node->isLeaf());
+            ASSERT_TRUE(!t.isLeaf(node));
         } else if (count == 2) {
-            ASSERT_TRUE(node->isLeaf());
+            ASSERT_TRUE(t.isLeaf(node));
         } else if (count > 2) {
             FAIL();
         }
@@ -260,7 +270,470 @@ TEST(QuadTreeTest, deconstructor_works) {
     tree.insert(elements);
 
     tree = {};
-    ASSERT_EQ(nullptr, tree.root->left);
-    ASSERT_EQ(nullptr, tree.root->right);
+    ASSERT_TRUE(tree.trees.empty());
     tree.insert(glm::vec3(1.0F), 1);
 }
+
+TEST(QuadTreeTest, retrieves_same_elements_as_brute_force_search) {
+    auto tree = QuadTree<unsigned int>(8);
+
+    std::vector<std::pair<glm::vec3, unsigned int>> elements = {};
+    std::srand(42);
+    for (unsigned int i = 0; i < 1000; i++) {
+        float x = static_cast<float>(std::rand() % 1000) - 500.0F;
+        float y = static_cast<float>(std::rand() % 1000) - 500.0F;
+        float z = static_cast<float>(std::rand() % 1000) - 500.0F;
+        elements.push_back(std::make_pair(glm::vec3(x, y, z), i));
+    }
+    tree.insert(elements);
+
+    const auto query = glm::vec3(12.5F, -3.0F, 100.0F);
+    std::sort(elements.begin(), elements.end(), [&query](const auto &a, const auto &b) {
+        return distanceSq(a.first, query) < distanceSq(b.first, query);
+    });
+
+    std::vector<unsigned int> result = {};
+    ASSERT_TRUE(tree.get(query, 10, result));
+    ASSERT_EQ(result.size(), 10);
+    for (unsigned int i = 0; i < result.size(); i++) {
+        ASSERT_EQ(result[i], elements[i].second);
+    }
+}
+
+TEST(QuadTreeTest, incremental_inserts_only_keep_a_logarithmic_number_of_trees) {
+    auto tree = QuadTree<unsigned int>(4);
+
+    const unsigned int width = 40;
+    const unsigned int height = 25;
+    for (unsigned int x = 0; x < width; x++) {
+        for (unsigned int z = 0; z < height; z++) {
+            tree.insert(glm::vec3(x, 0, z), x * height + z);
+        }
+    }
+
+    ASSERT_EQ(tree.size(), width * height);
+    ASSERT_LE(tree.trees.size(), 10);
+    for (unsigned int i = 1; i < tree.trees.size(); i++) {
+        ASSERT_GE(tree.trees[i - 1].size(), 2 * tree.trees[i].size());
+    }
+
+    unsigned int result = 0;
+    ASSERT_TRUE(tree.get(glm::vec3(17.1F, 0, 3.2F), result));
+    ASSERT_EQ(result, 17 * height + 3);
+}
+
+TEST(QuadTreeTest, bulk_insert_merges_with_existing_trees) {
+    auto tree = QuadTree<unsigned int>(2);
+    tree.insert(glm::vec3(10.0F), 10);
+
+    std::vector<std::pair<glm::vec3, unsigned int>> elements = {
+          std::make_pair(glm::vec3(1.0F), 1), //
+          std::make_pair(glm::vec3(2.0F), 2), //
+          std::make_pair(glm::vec3(3.0f), 3)  //
+    };
+    tree.insert(elements.begin(), elements.end());
+
+    ASSERT_EQ(tree.size(), 4);
+    ASSERT_EQ(tree.trees.size(), 1);
+
+    std::vector<unsigned int> result = {};
+    ASSERT_TRUE(tree.get(glm::vec3(9.0F), 2, result));
+    ASSERT_EQ(result.size(), 2);
+    ASSERT_EQ(result[0], 10);
+    ASSERT_EQ(result[1], 3);
+}
+
+TEST(QuadTreeTest, batch_query_returns_the_same_elements_as_single_queries) {
+    auto tree = QuadTree<unsigned int>(4);
+
+    std::vector<std::pair<glm::vec3, unsigned int>> elements = {};
+    const unsigned int width = 30;
+    const unsigned int height = 30;
+    for (unsigned int x = 0; x < width; x++) {
+        for (unsigned int z = 0; z < height; z++) {
+            elements.push_back(std::make_pair(glm::vec3(x, 0, z), x * height + z));
+        }
+    }
+    tree.insert(elements);
+
+    std::vector<glm::vec3> queries = {};
+    for (unsigned int i = 0; i < 200; i++) {
+        queries.emplace_back(static_cast<float>(i) * 0.13F, 0.0F, static_cast<float>(i % 31) + 0.4F);
+    }
+
+    QuadTree<unsigned int>::BatchResult batchResult = {};
+    ASSERT_TRUE(tree.getBatch(queries, 3, batchResult));
+    ASSERT_EQ(batchResult.offsets.size(), queries.size() + 1);
+    ASSERT_EQ(batchResult.values.size(), queries.size() * 3);
+
+    for (unsigned int i = 0; i < queries.size(); i++) {
+        std::vector<unsigned int> result = {};
+        ASSERT_TRUE(tree.get(queries[i], 3, result));
+        ASSERT_EQ(batchResult.offsets[i + 1] - batchResult.offsets[i], result.size());
+        for (unsigned int j = 0; j < result.size(); j++) {
+            ASSERT_EQ(batchResult.values[batchResult.offsets[i] + j], result[j]);
+        }
+    }
+}
+
+std::vector<std::pair<glm::vec3, unsigned int>> createRandomElements(unsigned int count) {
+    std::vector<std::pair<glm::vec3, unsigned int>> elements = {};
+    std::srand(7);
+    for (unsigned int i = 0; i < count; i++) {
+        float x = static_cast<float>(std::rand() % 200) - 100.0F;
+        float y = static_cast<float>(std::rand() % 200) - 100.0F;
+        float z = static_cast<float>(std::rand() % 200) - 100.0F;
+        elements.push_back(std::make_pair(glm::vec3(x, y, z), i));
+    }
+    return elements;
+}
+
+TEST(QuadTreeTest, can_retrieve_elements_in_radius) {
+    auto tree = QuadTree<unsigned int>(8);
+    const auto elements = createRandomElements(2000);
+    tree.insert(elements);
+
+    const auto center = glm::vec3(10.0F, -20.0F, 5.0F);
+    const float radius = 40.0F;
+    unsigned int expected = 0;
+    for (const auto &element : elements) {
+        if (distanceSq(element.first, center) <= radius * radius) {
+            expected++;
+        }
+    }
+
+    unsigned int count = 0;
+    tree.getInRadius(center, radius, [&](const glm::vec3 &point, const unsigned int &) {
+        ASSERT_LE(distanceSq(point, center), radius * radius);
+        count++;
+    });
+    ASSERT_GT(expected, 0);
+    ASSERT_EQ(count, expected);
+}
+
+TEST(QuadTreeTest, can_retrieve_elements_in_box) {
+    auto tree = QuadTree<unsigned int>(8);
+    const auto elements = createRandomElements(2000);
+    tree.insert(elements);
+
+    BoundingBox3 box = {};
+    box.update(glm::vec3(-50.0F, -10.0F, 0.0F));
+    box.update(glm::vec3(20.0F, 60.0F, 30.0F));
+    unsigned int expected = 0;
+    for (const auto &element : elements) {
+        if (box.contains(element.first)) {
+            expected++;
+        }
+    }
+
+    unsigned int count = 0;
+    tree.getInBox(box, [&](const glm::vec3 &point, const unsigned int &) {
+        ASSERT_TRUE(box.contains(point));
+        count++;
+    });
+    ASSERT_GT(expected, 0);
+    ASSERT_EQ(count, expected);
+}
+
+TEST(QuadTreeTest, can_retrieve_elements_in_frustum) {
+    auto tree = QuadTree<unsigned int>(8);
+    const auto elements = createRandomElements(2000);
+    tree.insert(elements);
+
+    // looking down the x axis from the origin with a 90 degree field of view
+    Frustum frustum = {};
+    frustum.planes = {
+          glm::vec4(1.0F, 0.0F, 1.0F, 0.0F),   //
+          glm::vec4(1.0F, 0.0F, -1.0F, 0.0F),  //
+          glm::vec4(1.0F, 1.0F, 0.0F, 0.0F),   //
+          glm::vec4(1.0F, -1.0F, 0.0F, 0.0F),  //
+          glm::vec4(1.0F, 0.0F, 0.0F, -5.0F),  //
+          glm::vec4(-1.0F, 0.0F, 0.0F, 80.0F), //
+    };
+    unsigned int expected = 0;
+    for (const auto &element : elements) {
+        if (frustum.contains(element.first)) {
+            expected++;
+        }
+    }
+
+    unsigned int count = 0;
+    tree.getInFrustum(frustum, [&](const glm::vec3 &point, const unsigned int &) {
+        ASSERT_TRUE(frustum.contains(point));
+        count++;
+    });
+    ASSERT_GT(expected, 0);
+    ASSERT_EQ(count, expected);
+}
+
+TEST(QuadTreeTest, can_save_and_map_tree) {
+    auto tree = QuadTree<unsigned int>(4);
+    for (unsigned int x = 0; x < 20; x++) {
+        for (unsigned int z = 0; z < 15; z++) {
+            tree.insert(glm::vec3(x, 0, z), x * 15 + z);
+        }
+    }
+
+    const auto filePath = (std::filesystem::temp_directory_path() / "quad_tree_test.bin").string();
+    ASSERT_TRUE(tree.save(filePath));
+
+    auto mappedTreeOpt = QuadTree<unsigned int>::openMapped(filePath);
+    ASSERT_TRUE(mappedTreeOpt.has_value());
+    auto &mappedTree = mappedTreeOpt.value();
+    ASSERT_EQ(mappedTree.size(), tree.size());
+    ASSERT_EQ(mappedTree.trees.size(), tree.trees.size());
+    ASSERT_EQ(mappedTree.maxElementsPerNode, tree.maxElementsPerNode);
+
+    for (unsigned int i = 0; i < 50; i++) {
+        const auto query = glm::vec3(static_cast<float>(i) * 0.4F, 1.0F, static_cast<float>(i % 15) + 0.3F);
+        std::vector<unsigned int> expected = {};
+        std::vector<unsigned int> actual = {};
+        ASSERT_TRUE(tree.get(query, 5, expected));
+        ASSERT_TRUE(mappedTree.get(query, 5, actual));
+        ASSERT_EQ(actual, expected);
+    }
+
+    // inserting merges the mapped trees into new ones
+    mappedTree.insert(glm::vec3(100.0F), 1000);
+    unsigned int result = 0;
+    ASSERT_TRUE(mappedTree.get(glm::vec3(99.0F), result));
+    ASSERT_EQ(result, 1000);
+    ASSERT_EQ(mappedTree.size(), tree.size() + 1);
+
+    std::filesystem::remove(filePath);
+}
+
+TEST(QuadTreeTest, fails_to_map_invalid_file) {
+    const auto filePath = (std::filesystem::temp_directory_path() / "quad_tree_test_invalid.bin").string();
+    {
+        auto fs = std::ofstream(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+        fs << "this is not a quad tree, but it is long enough to contain a header";
+    }
+
+    ASSERT_FALSE(QuadTree<unsigned int>::openMapped(filePath).has_value());
+    ASSERT_FALSE(QuadTree<uint64_t>::openMapped(filePath + ".does_not_exist").has_value());
+
+    std::filesystem::remove(filePath);
+}
+
+TEST(QuadTreeTest, fails_to_map_corrupted_tree) {
+    auto tree = QuadTree<unsigned int>(4);
+    for (unsigned int i = 0; i < 100; i++) {
+        tree.insert(glm::vec3(static_cast<float>(i), 0.0F, 0.0F), i);
+    }
+
+    const auto filePath = (std::filesystem::temp_directory_path() / "quad_tree_test_corrupted.bin").string();
+    ASSERT_TRUE(tree.save(filePath));
+    std::vector<char> original = {};
+    {
+        auto is = std::ifstream(filePath, std::ios::in | std::ios::binary);
+        original.assign(std::istreambuf_iterator<char>(is), {});
+    }
+    ASSERT_TRUE(QuadTree<unsigned int>::openMapped(filePath).has_value());
+
+    // the sections are all inside of the file, but their content is not
+    const auto writeCorrupted = [&](const auto &corrupt) {
+        auto data = original;
+        QuadTreeFileTree fileTree = {};
+        std::memcpy(&fileTree, data.data() + sizeof(QuadTreeFileHeader), sizeof(fileTree));
+        corrupt(data, fileTree);
+        std::memcpy(data.data() + sizeof(QuadTreeFileHeader), &fileTree, sizeof(fileTree));
+        auto fs = std::ofstream(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+        fs.write(data.data(), static_cast<std::streamsize>(data.size()));
+    };
+
+    writeCorrupted([](std::vector<char> &, QuadTreeFileTree &fileTree) { fileTree.nodeCount = 0; });
+    ASSERT_FALSE(QuadTree<unsigned int>::openMapped(filePath).has_value());
+
+    using Node = QuadTree<unsigned int>::Node;
+    writeCorrupted([](std::vector<char> &data, QuadTreeFileTree &fileTree) {
+        Node node = {};
+        const auto offset = fileTree.nodesOffset + (fileTree.nodeCount - 1) * sizeof(Node);
+        std::memcpy(&node, data.data() + offset, sizeof(node));
+        node.end = static_cast<unsigned int>(fileTree.elementCount) + 1000;
+        std::memcpy(data.data() + offset, &node, sizeof(node));
+    });
+    ASSERT_FALSE(QuadTree<unsigned int>::openMapped(filePath).has_value());
+
+    writeCorrupted([](std::vector<char> &data, QuadTreeFileTree &fileTree) {
+        Node node = {};
+        std::memcpy(&node, data.data() + fileTree.nodesOffset, sizeof(node));
+        node.begin = node.end + 1;
+        std::memcpy(data.data() + fileTree.nodesOffset, &node, sizeof(node));
+    });
+    ASSERT_FALSE(QuadTree<unsigned int>::openMapped(filePath).has_value());
+
+    std::filesystem::remove(filePath);
+}
+
+/*
+ * Compares the distances instead of the values, because the Manhattan and Chebyshev metrics produce many ties.
+ * The value of each element is its index in elements.
+ */
+template <typename TreeType>
+void expectSameDistancesAsBruteForce(const std::vector<typename TreeType::Element> &elements,
+                                     const typename TreeType::Vec &query, const unsigned int k) {
+    using Metric = typename TreeType::MetricType;
+    constexpr auto D = TreeType::DIMENSION;
+
+    auto tree = TreeType(8);
+    tree.insert(elements);
+
+    std::vector<float> expected = {};
+    for (const auto &element : elements) {
+        expected.push_back(reducedDistance<Metric, D>(element.first, query));
+    }
+    std::sort(expected.begin(), expected.end());
+
+    std::vector<unsigned int> result = {};
+    ASSERT_TRUE(tree.get(query, k, result));
+    ASSERT_EQ(result.size(), k);
+    for (unsigned int i = 0; i < result.size(); i++) {
+        const float distance = reducedDistance<Metric, D>(elements[result[i]].first, query);
+        ASSERT_EQ(distance, expected[i]);
+    }
+}
+
+TEST(QuadTreeTest, two_dimensional_tree_retrieves_same_elements_as_brute_force_search) {
+    std::vector<std::pair<glm::vec2, unsigned int>> elements = {};
+    for (const auto &element : createRandomElements(1000)) {
+        elements.push_back(std::make_pair(glm::vec2(element.first.x, element.first.z), element.second));
+    }
+
+    expectSameDistancesAsBruteForce<QuadTree<unsigned int, 2>>(elements, glm::vec2(12.5F, -3.0F), 10);
+    expectSameDistancesAsBruteForce<QuadTree<unsigned int, 2, ManhattanMetric>>(elements, glm::vec2(0.5F), 10);
+}
+
+TEST(QuadTreeTest, other_metrics_retrieve_same_distances_as_brute_force_search) {
+    const auto elements = createRandomElements(1000);
+    const auto query = glm::vec3(12.5F, -3.0F, 50.0F);
+
+    expectSameDistancesAsBruteForce<QuadTree<unsigned int, 3, ManhattanMetric>>(elements, query, 20);
+    expectSameDistancesAsBruteForce<QuadTree<unsigned int, 3, ChebyshevMetric>>(elements, query, 20);
+}
+
+TEST(QuadTreeTest, can_split_along_custom_axes) {
+    using RoundRobinTree = QuadTree<unsigned int, 3, EuclideanMetric, SplitAxes<0, 1, 2>>;
+    using RoundRobinNodes = RoundRobinTree::Tree;
+    ASSERT_EQ(RoundRobinNodes::axis(RoundRobinNodes::ROOT), 0);
+    ASSERT_EQ(RoundRobinNodes::axis(RoundRobinNodes::left(RoundRobinNodes::ROOT)), 1);
+    ASSERT_EQ(RoundRobinNodes::axis(RoundRobinNodes::left(RoundRobinNodes::left(RoundRobinNodes::ROOT))), 2);
+    ASSERT_EQ(RoundRobinNodes::axis(7), 0);
+
+    expectSameDistancesAsBruteForce<RoundRobinTree>(createRandomElements(1000), glm::vec3(12.5F, -3.0F, 50.0F), 10);
+}
+
+TEST(QuadTreeTest, chebyshev_radius_describes_a_box) {
+    auto tree = QuadTree<unsigned int, 3, ChebyshevMetric>(8);
+    tree.insert(createRandomElements(2000));
+
+    const auto center = glm::vec3(10.0F, -20.0F, 5.0F);
+    const float radius = 30.0F;
+    BoundingBox3 box = {};
+    box.update(center - radius);
+    box.update(center + radius);
+
+    unsigned int expected = 0;
+    tree.getInBox(box, [&expected](const glm::vec3 &, const unsigned int &) { expected++; });
+
+    unsigned int count = 0;
+    tree.getInRadius(center, radius, [&](const glm::vec3 &point, const unsigned int &) {
+        ASSERT_TRUE(box.contains(point));
+        count++;
+    });
+    ASSERT_GT(expected, 0);
+    ASSERT_EQ(count, expected);
+}
+
+TEST(QuadTreeTest, approximate_search_stays_within_epsilon) {
+    auto tree = QuadTree<unsigned int>(8);
+    const auto elements = createRandomElements(2000);
+    tree.insert(elements);
+
+    const auto query = glm::vec3(12.5F, -3.0F, 50.0F);
+    std::vector<float> expected = {};
+    for (const auto &element : elements) {
+        expected.push_back(std::sqrt(distanceSq(element.first, query)));
+    }
+    std::sort(expected.begin(), expected.end());
+
+    for (const float epsilon : {0.0F, 0.5F, 2.0F}) {
+        std::vector<unsigned int> result = {};
+        ASSERT_TRUE(tree.get(query, 10, result, {.epsilon = epsilon}));
+        ASSERT_EQ(result.size(), 10);
+        for (unsigned int i = 0; i < result.size(); i++) {
+            const float distance = std::sqrt(distanceSq(elements[result[i]].first, query));
+            ASSERT_GE(distance, expected[i]);
+            ASSERT_LE(distance, expected[i] * (1.0F + epsilon) + 1e-3F);
+        }
+    }
+}
+
+TEST(QuadTreeTest, search_stops_after_max_leaves) {
+    auto tree = QuadTree<unsigned int>(8);
+    const auto elements = createRandomElements(2000);
+    tree.insert(elements);
+
+    const auto query = glm::vec3(12.5F, -3.0F, 50.0F);
+    std::vector<unsigned int> exact = {};
+    ASSERT_TRUE(tree.get(query, 4, exact));
+
+    std::vector<unsigned int> result = {};
+    ASSERT_TRUE(tree.get(query, 4, result, {.maxLeaves = 1}));
+    ASSERT_EQ(result.size(), 4);
+    for (unsigned int i = 0; i < result.size(); i++) {
+        ASSERT_GE(distanceSq(elements[result[i]].first, query), distanceSq(elements[exact[i]].first, query));
+    }
+
+    result.clear();
+    ASSERT_TRUE(tree.get(query, 4, result, {.maxLeaves = 0}));
+    ASSERT_TRUE(result.empty());
+
+    result.clear();
+    ASSERT_TRUE(tree.get(query, 4, result, {.maxLeaves = 1000}));
+    ASSERT_EQ(result, exact);
+}
+
+/*
+ * Scans the points [first, last) with at most LANE_COUNT lanes at once.
+ * With shrinkBound, every accepted distance becomes the new bound, like in a search for the nearest element.
+ */
+template <typename Metric, unsigned int LANE_COUNT>
+std::vector<std::pair<unsigned int, float>> scanWithLanes(const std::array<std::span<const float>, 3> &coords,
+                                                          unsigned int first, unsigned int last,
+                                                          const glm::vec3 &query, bool shrinkBound) {
+    std::vector<std::pair<unsigned int, float>> accepted = {};
+    const float bound = Metric::term(40.0F);
+    scanDistances<Metric, 3, LANE_COUNT>(coords, first, last, query, bound, [&](unsigned int index, float distance) {
+        accepted.emplace_back(index, distance);
+        return shrinkBound ? distance : bound;
+    });
+    return accepted;
+}
+
+template <typename Metric> void expectSameScanForAllLaneCounts() {
+    const auto elements = createRandomElements(200);
+    std::array<std::vector<float>, 3> axisCoords = {};
+    for (const auto &element : elements) {
+        for (glm::length_t axis = 0; axis < 3; axis++) {
+            axisCoords[axis].push_back(element.first[axis]);
+        }
+    }
+    const std::array<std::span<const float>, 3> coords = {axisCoords[0], axisCoords[1], axisCoords[2]};
+
+    const auto query = glm::vec3(12.5F, -3.0F, 50.0F);
+    for (const bool shrinkBound : {false, true}) {
+        // an odd start, so that the lanes do not line up with the beginning of the arrays
+        for (unsigned int count = 0; count <= 150; count++) {
+            const auto expected = scanWithLanes<Metric, 1>(coords, 3, 3 + count, query, shrinkBound);
+            ASSERT_EQ((scanWithLanes<Metric, 4>(coords, 3, 3 + count, query, shrinkBound)), expected);
+            ASSERT_EQ((scanWithLanes<Metric, 8>(coords, 3, 3 + count, query, shrinkBound)), expected);
+        }
+    }
+}
+
+TEST(QuadTreeTest, distance_scan_is_the_same_for_all_lane_counts) {
+    expectSameScanForAllLaneCounts<EuclideanMetric>();
+    expectSameScanForAllLaneCounts<ManhattanMetric>();
+    expectSameScanForAllLaneCounts<ChebyshevMetric>();
+}